@@ -0,0 +1,113 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#define BOOST_TEST_MODULE zeq_dispatcher
+
+#include "broker.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace zeq::vocabulary;
+
+BOOST_AUTO_TEST_CASE(invalid_construction)
+{
+    BOOST_CHECK_THROW( zeq::Dispatcher( 0 ), std::runtime_error );
+    BOOST_CHECK_THROW( zeq::Dispatcher( 1, 0 ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE(ordered_per_key)
+{
+    const size_t numKeys = 8;
+    const size_t numTasks = 1000;
+    std::vector< std::vector< size_t > > results( numKeys );
+    std::vector< std::unique_ptr< std::mutex > > mutexes;
+    for( size_t i = 0; i < numKeys; ++i )
+        mutexes.emplace_back( new std::mutex );
+
+    zeq::Dispatcher dispatcher( 4, 16 );
+    for( size_t i = 0; i < numTasks; ++i )
+    {
+        const size_t key = i % numKeys;
+        dispatcher.post( zeq::uint128_t( key ), [&, key, i]
+        {
+            std::lock_guard< std::mutex > lock( *mutexes[key] );
+            results[key].push_back( i );
+        });
+    }
+    dispatcher.wait();
+
+    for( size_t key = 0; key < numKeys; ++key )
+    {
+        BOOST_REQUIRE_EQUAL( results[key].size(), numTasks / numKeys );
+        for( size_t i = 1; i < results[key].size(); ++i )
+            BOOST_CHECK_LT( results[key][i-1], results[key][i] );
+    }
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_keys)
+{
+    // a blocked key does not hold back other keys
+    std::atomic< bool > release( false );
+    std::atomic< bool > ran( false );
+
+    zeq::Dispatcher dispatcher( 2 );
+    dispatcher.post( zeq::uint128_t( 1 ), [&]
+    {
+        while( !release )
+            std::this_thread::yield();
+    });
+    dispatcher.post( zeq::uint128_t( 2 ), [&] { ran = true; });
+
+    for( size_t i = 0; i < 100 && !ran; ++i )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ));
+    BOOST_CHECK( ran );
+    release = true;
+}
+
+BOOST_AUTO_TEST_CASE(post_from_worker)
+{
+    // the only worker must not wait for itself on a full queue
+    const size_t numTasks = 10;
+    std::atomic< size_t > ran( 0 );
+
+    zeq::Dispatcher dispatcher( 1, 1 );
+    dispatcher.post( zeq::uint128_t( 1 ), [&]
+    {
+        for( size_t i = 0; i < numTasks; ++i )
+            dispatcher.post( zeq::uint128_t( 1 ), [&] { ++ran; });
+    });
+    dispatcher.wait();
+    BOOST_CHECK_EQUAL( ran.load(), numTasks );
+}
+
+BOOST_AUTO_TEST_CASE(subscriber_dispatch)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( test::buildURI( "localhost", publisher ));
+    zeq::Dispatcher dispatcher( 2 );
+    subscriber.setDispatcher( &dispatcher );
+
+    const std::thread::id receiveThread = std::this_thread::get_id();
+    std::atomic< bool > received( false );
+    std::atomic< bool > onWorker( false );
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+        [&]( const zeq::Event& event )
+        {
+            onWorker = std::this_thread::get_id() != receiveThread &&
+                       deserializeEcho( event ) == test::echoMessage;
+            received = true;
+        }));
+
+    for( size_t i = 0; i < 20 && !received; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        subscriber.receive( 100 );
+        dispatcher.wait();
+    }
+    BOOST_CHECK( received );
+    BOOST_CHECK( onWorker );
+}
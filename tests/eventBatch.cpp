@@ -0,0 +1,121 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#define BOOST_TEST_MODULE zeq_event_batch
+
+#include <zeq/eventBatch.h>
+
+#include <servus/uint128_t.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+const zeq::uint128_t typeA = servus::make_uint128( "zeq::test::A" );
+const zeq::uint128_t typeB = servus::make_uint128( "zeq::test::B" );
+
+std::string getString( const zeq::EventBatch& batch, const size_t index )
+{
+    return std::string( static_cast< const char* >( batch.getData( index )),
+                        batch.getSize( index ));
+}
+}
+
+BOOST_AUTO_TEST_CASE(add_get)
+{
+    zeq::EventBatch batch;
+    BOOST_CHECK( batch.empty( ));
+
+    const std::string foo( "foo" );
+    const std::string hello( "hello batch" );
+    batch.add( typeA, foo.data(), foo.size( ));
+    batch.add( typeB, nullptr, 0 );
+    batch.add( typeA, hello.data(), hello.size( ));
+
+    BOOST_REQUIRE_EQUAL( batch.size(), 3 );
+    BOOST_CHECK_EQUAL( batch.getType( 0 ), typeA );
+    BOOST_CHECK_EQUAL( batch.getType( 1 ), typeB );
+    BOOST_CHECK_EQUAL( batch.getType( 2 ), typeA );
+    BOOST_CHECK_EQUAL( getString( batch, 0 ), foo );
+    BOOST_CHECK_EQUAL( batch.getSize( 1 ), 0 );
+    BOOST_CHECK_EQUAL( getString( batch, 2 ), hello );
+
+    // FlatBuffers are read in place
+    for( size_t i = 0; i < batch.size(); ++i )
+        BOOST_CHECK_EQUAL( reinterpret_cast< uintptr_t >(
+                               batch.getData( i )) % 8, 0 );
+
+    zeq::EventBatch copy;
+    copy.add( batch );
+    BOOST_REQUIRE_EQUAL( copy.size(), 3 );
+    BOOST_CHECK_EQUAL( getString( copy, 2 ), hello );
+
+    batch.clear();
+    BOOST_CHECK( batch.empty( ));
+    BOOST_CHECK_EQUAL( copy.size(), 3 );
+}
+
+BOOST_AUTO_TEST_CASE(reuse_memory)
+{
+    zeq::EventBatch batch;
+    batch.reserve( 100, 100 * 64 );
+
+    const std::string payload( 64, 'x' );
+    batch.add( typeA, payload.data(), payload.size( ));
+    const void* first = batch.getData( 0 );
+    for( size_t i = 1; i < 100; ++i )
+        batch.add( typeA, payload.data(), payload.size( ));
+    BOOST_CHECK_EQUAL( batch.getData( 0 ), first );
+
+    batch.clear();
+    for( size_t i = 0; i < 100; ++i )
+        batch.add( typeB, payload.data(), payload.size( ));
+    BOOST_CHECK_EQUAL( batch.getData( 0 ), first );
+    BOOST_CHECK_EQUAL( getString( batch, 99 ), payload );
+}
+
+BOOST_AUTO_TEST_CASE(take_move)
+{
+    zeq::EventBatch pending;
+    const std::string payload( 100, 'x' );
+    for( size_t i = 0; i < 10; ++i )
+    {
+        const std::string& data = std::to_string( i );
+        pending.add( i % 2 ? typeA : typeB, data.data(), data.size( ));
+    }
+    pending.add( typeB, payload.data(), payload.size( ));
+    const void* memory = pending.getData( 0 );
+
+    zeq::EventBatch batch;
+    batch.take( pending, typeA );
+    BOOST_REQUIRE_EQUAL( batch.size(), 5 );
+    BOOST_REQUIRE_EQUAL( pending.size(), 6 );
+    for( size_t i = 0; i < 5; ++i )
+    {
+        BOOST_CHECK_EQUAL( batch.getType( i ), typeA );
+        BOOST_CHECK_EQUAL( getString( batch, i ), std::to_string( i * 2 + 1 ));
+        BOOST_CHECK_EQUAL( pending.getType( i ), typeB );
+        BOOST_CHECK_EQUAL( getString( pending, i ), std::to_string( i * 2 ));
+    }
+    BOOST_CHECK_EQUAL( getString( pending, 5 ), payload );
+    BOOST_CHECK_EQUAL( pending.getData( 0 ), memory );
+
+    // moves keep the memory
+    zeq::EventBatch moved( std::move( pending ));
+    BOOST_CHECK( pending.empty( ));
+    BOOST_CHECK_EQUAL( moved.getData( 0 ), memory );
+    pending = std::move( moved );
+    BOOST_CHECK( moved.empty( ));
+    BOOST_REQUIRE_EQUAL( pending.size(), 6 );
+    BOOST_CHECK_EQUAL( pending.getData( 0 ), memory );
+
+    const zeq::EventBatch copy( pending );
+    BOOST_REQUIRE_EQUAL( copy.size(), 6 );
+    BOOST_CHECK_NE( copy.getData( 0 ), memory );
+    BOOST_CHECK_EQUAL( getString( copy, 5 ), payload );
+}
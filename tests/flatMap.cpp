@@ -0,0 +1,99 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#define BOOST_TEST_MODULE zeq_flat_map
+
+#include <zeq/detail/flatMap.h>
+#include <zeq/types.h>
+
+#include <servus/uint128_t.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <map>
+#include <random>
+
+namespace
+{
+std::vector< zeq::uint128_t > makeTypes( const size_t numTypes )
+{
+    std::vector< zeq::uint128_t > types;
+    for( size_t i = 0; i < numTypes; ++i )
+        types.push_back( servus::make_uint128( "zeq::test::Type" +
+                                               std::to_string( i )));
+    return types;
+}
+}
+
+BOOST_AUTO_TEST_CASE(insert_find_erase)
+{
+    zeq::detail::FlatMap< size_t > map;
+    std::map< zeq::uint128_t, size_t > reference;
+    const std::vector< zeq::uint128_t >& types = makeTypes( 500 );
+
+    std::mt19937 random( 42 );
+    for( size_t i = 0; i < 10000; ++i )
+    {
+        const zeq::uint128_t& type = types[ random() % types.size() ];
+        if( random() % 3 == 0 )
+            BOOST_CHECK_EQUAL( map.erase( type ), reference.erase( type ) > 0 );
+        else
+        {
+            map[ type ] = i;
+            reference[ type ] = i;
+        }
+    }
+
+    BOOST_CHECK_EQUAL( map.size(), reference.size( ));
+    for( const zeq::uint128_t& type : types )
+    {
+        const size_t* value = map.find( type );
+        const auto i = reference.find( type );
+        BOOST_REQUIRE_EQUAL( !value, i == reference.end( ));
+        if( value )
+            BOOST_CHECK_EQUAL( *value, i->second );
+    }
+
+    size_t numEntries = 0;
+    map.forEach( [&]( const zeq::uint128_t&, const size_t& ) { ++numEntries; });
+    BOOST_CHECK_EQUAL( numEntries, reference.size( ));
+}
+
+BOOST_AUTO_TEST_CASE(lookup_benchmark)
+{
+    // Per-message cost of resolving the event type of a received message
+    const size_t numLookups = 1000000;
+    for( size_t numTypes = 10; numTypes <= 1000; numTypes *= 10 )
+    {
+        const std::vector< zeq::uint128_t >& types = makeTypes( numTypes );
+        zeq::detail::FlatMap< zeq::EventFunc > map;
+        std::map< zeq::uint128_t, zeq::EventFunc > reference;
+        for( const zeq::uint128_t& type : types )
+        {
+            map[ type ] = []( const zeq::Event& ) {};
+            reference[ type ] = []( const zeq::Event& ) {};
+        }
+
+        size_t found = 0;
+        auto startTime = std::chrono::high_resolution_clock::now();
+        for( size_t i = 0; i < numLookups; ++i )
+            found += map.find( types[ i % numTypes ] ) ? 1 : 0;
+        const auto flatTime = std::chrono::high_resolution_clock::now() -
+                              startTime;
+
+        startTime = std::chrono::high_resolution_clock::now();
+        for( size_t i = 0; i < numLookups; ++i )
+            found += reference.count( types[ i % numTypes ] );
+        const auto treeTime = std::chrono::high_resolution_clock::now() -
+                              startTime;
+
+        BOOST_CHECK_EQUAL( found, 2 * numLookups );
+        BOOST_TEST_MESSAGE( numTypes << " types: " <<
+                 std::chrono::nanoseconds( flatTime ).count() / numLookups <<
+                 " ns flat map, " <<
+                 std::chrono::nanoseconds( treeTime ).count() / numLookups <<
+                 " ns std::map per lookup" );
+    }
+}
@@ -0,0 +1,96 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#define BOOST_TEST_MODULE hbp_allocations
+
+#include <zeq/hbp/vocabulary.h>
+#include <zeq/zeq.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+// heap allocations of the calling thread, ZeroMQ's threads are not counted
+thread_local size_t _allocations = 0;
+}
+
+void* operator new( const size_t size )
+{
+    ++_allocations;
+    if( void* ptr = std::malloc( size ? size : 1 ))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete( void* ptr ) noexcept
+{
+    std::free( ptr );
+}
+
+BOOST_AUTO_TEST_CASE(frame_event_construction)
+{
+    const zeq::hbp::data::Frame frame( 0, 42, 100, 1 );
+    {
+        // warm up the pools of this thread
+        const zeq::Event& event = zeq::hbp::serializeFrame( frame );
+        BOOST_CHECK_EQUAL( zeq::hbp::deserializeFrame( event ), frame );
+    }
+
+    // checked after counting, the test framework may allocate
+    size_t mismatches = 0;
+    const size_t allocations = _allocations;
+    for( size_t i = 0; i < 100; ++i )
+    {
+        const zeq::Event& event = zeq::hbp::serializeFrame( frame );
+        if( !( zeq::hbp::deserializeFrame( event ) == frame ))
+            ++mismatches;
+    }
+    BOOST_CHECK_EQUAL( _allocations - allocations, 0 );
+    BOOST_CHECK_EQUAL( mismatches, 0 );
+}
+
+BOOST_AUTO_TEST_CASE(frame_publish_receive)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+
+    zeq::hbp::data::Frame received;
+    size_t numReceived = 0;
+    BOOST_CHECK( subscriber.registerHandler( zeq::hbp::EVENT_FRAME,
+        [&]( const zeq::Event& event )
+        {
+            received = zeq::hbp::deserializeFrame( event );
+            ++numReceived;
+        }));
+
+    zeq::hbp::data::Frame frame( 0, 0, 1000, 1 );
+    for( size_t i = 0; i < 20 && numReceived == 0; ++i )
+    {
+        BOOST_CHECK( publisher.publish( zeq::hbp::serializeFrame( frame )));
+        subscriber.receive( 100 );
+    }
+    BOOST_REQUIRE_GT( numReceived, 0 );
+    while( subscriber.receive( 100 )) {}
+
+    // steady state: publish and receive without heap allocations
+    numReceived = 0;
+    size_t failures = 0;
+    const size_t allocations = _allocations;
+    for( uint32_t i = 0; i < 100; ++i )
+    {
+        frame.current = i;
+        if( !publisher.publish( zeq::hbp::serializeFrame( frame )) ||
+            !subscriber.receive( 1000 ) || !( received == frame ))
+        {
+            ++failures;
+        }
+    }
+    BOOST_CHECK_EQUAL( _allocations - allocations, 0 );
+    BOOST_CHECK_EQUAL( failures, 0 );
+    BOOST_CHECK_EQUAL( numReceived, 100 );
+}
@@ -0,0 +1,125 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#define BOOST_TEST_MODULE hbp_idSet
+
+#include <zeq/hbp/idSet.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+
+using zeq::hbp::data::IDSet;
+typedef std::vector< uint32_t > uint32_ts;
+
+namespace
+{
+IDSet makeSet( const uint32_t start, const uint32_t count )
+{
+    IDSet set;
+    set.add( start, count );
+    return set;
+}
+}
+
+BOOST_AUTO_TEST_CASE( construction )
+{
+    const IDSet empty;
+    BOOST_CHECK( empty.empty( ));
+    BOOST_CHECK_EQUAL( empty.size(), 0 );
+    BOOST_CHECK( empty.getRanges().empty( ));
+
+    const uint32_t ids[] = { 7, 3, 5, 4, 3, 42, 6, 43 };
+    const IDSet set( uint32_ts( ids, ids + 8 ));
+    BOOST_CHECK_EQUAL( set.size(), 7 );
+    BOOST_REQUIRE_EQUAL( set.getRanges().size(), 2 );
+    BOOST_CHECK_EQUAL( set.getRanges()[0].start, 3 );
+    BOOST_CHECK_EQUAL( set.getRanges()[0].count, 5 );
+    BOOST_CHECK_EQUAL( set.getRanges()[1].start, 42 );
+    BOOST_CHECK_EQUAL( set.getRanges()[1].count, 2 );
+
+    const uint32_t expected[] = { 3, 4, 5, 6, 7, 42, 43 };
+    const uint32_ts sorted = set.toIDs();
+    BOOST_CHECK_EQUAL_COLLECTIONS( sorted.begin(), sorted.end(),
+                                   expected, expected + 7 );
+    BOOST_CHECK( set.contains( 5 ));
+    BOOST_CHECK( set.contains( 43 ));
+    BOOST_CHECK( !set.contains( 8 ));
+    BOOST_CHECK( !set.contains( 2 ));
+}
+
+BOOST_AUTO_TEST_CASE( rangeConstruction )
+{
+    // unsorted, overlapping, adjacent and empty runs
+    const IDSet::Range ranges[] = { { 42, 2 }, { 3, 3 }, { 5, 2 }, { 8, 0 },
+                                    { 4, 1 }, { 44, 1 } };
+    const IDSet set( IDSet::Ranges( ranges, ranges + 6 ));
+    BOOST_CHECK_EQUAL( set.size(), 7 );
+    BOOST_REQUIRE_EQUAL( set.getRanges().size(), 2 );
+    BOOST_CHECK_EQUAL( set.getRanges()[0].start, 3 );
+    BOOST_CHECK_EQUAL( set.getRanges()[0].count, 4 );
+    BOOST_CHECK_EQUAL( set.getRanges()[1].start, 42 );
+    BOOST_CHECK_EQUAL( set.getRanges()[1].count, 3 );
+    BOOST_CHECK( set == IDSet( set.getRanges( )));
+}
+
+BOOST_AUTO_TEST_CASE( add )
+{
+    IDSet set;
+    set.add( 10, 10 );
+    set.add( 30, 10 );
+    set.add( 20, 10 ); // fills the gap
+    BOOST_CHECK( set == makeSet( 10, 30 ));
+
+    set.add( 0, 5 );
+    set.add( 3, 5 ); // overlaps the first run
+    BOOST_REQUIRE_EQUAL( set.getRanges().size(), 2 );
+    BOOST_CHECK_EQUAL( set.getRanges()[0].count, 8 );
+    BOOST_CHECK_EQUAL( set.size(), 38 );
+
+    set.add( 100, 0 );
+    BOOST_CHECK_EQUAL( set.size(), 38 );
+
+    set.clear();
+    BOOST_CHECK( set.empty( ));
+}
+
+BOOST_AUTO_TEST_CASE( fullRange )
+{
+    const uint32_t max = std::numeric_limits< uint32_t >::max();
+    IDSet set;
+    set.add( 0, max );
+    set.add( max );
+    BOOST_CHECK_EQUAL( set.size(), size_t( max ) + 1 );
+    BOOST_CHECK( set.contains( 0 ));
+    BOOST_CHECK( set.contains( max ));
+
+    const IDSet rest = subtract( set, makeSet( 1, max - 1 ));
+    BOOST_CHECK_EQUAL( rest.size(), 2 );
+    BOOST_CHECK( rest.contains( 0 ));
+    BOOST_CHECK( rest.contains( max ));
+    BOOST_CHECK( subtract( set, set ).empty( ));
+}
+
+BOOST_AUTO_TEST_CASE( operations )
+{
+    const IDSet a = makeSet( 0, 100 );
+    const IDSet b = makeSet( 50, 100 );
+
+    BOOST_CHECK( unite( a, b ) == makeSet( 0, 150 ));
+    BOOST_CHECK( subtract( a, b ) == makeSet( 0, 50 ));
+    BOOST_CHECK( subtract( b, a ) == makeSet( 100, 50 ));
+
+    IDSet expected = makeSet( 0, 50 );
+    expected.add( 100, 50 );
+    BOOST_CHECK( toggle( a, b ) == expected );
+    BOOST_CHECK( toggle( toggle( a, b ), b ) == a );
+
+    BOOST_CHECK( unite( a, IDSet( )) == a );
+    BOOST_CHECK( subtract( a, IDSet( )) == a );
+    BOOST_CHECK( subtract( IDSet(), a ).empty( ));
+    BOOST_CHECK( unite( makeSet( 0, 10 ), makeSet( 10, 10 )) ==
+                 makeSet( 0, 20 ));
+}
@@ -11,6 +11,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <cstring>
+
 typedef std::vector< uint32_t > uint32_ts;
 
 BOOST_AUTO_TEST_CASE( cameraEvent )
@@ -126,3 +128,167 @@ BOOST_AUTO_TEST_CASE( cellSetBinaryOp )
                                  deserializedCellSetBinaryOp.second.begin( ),
                                  deserializedCellSetBinaryOp.second.end( ));
 }
+
+BOOST_AUTO_TEST_CASE( selectionsViewAndReuse )
+{
+    zeq::hbp::uint32_ts selection( 100000 );
+    for( size_t i = 0; i < selection.size(); ++i )
+        selection[i] = uint32_t( i * 3 );
+    const zeq::Event& event = zeq::hbp::serializeSelectedIDs( selection );
+
+    const zeq::hbp::data::Span< uint32_t > view =
+        zeq::hbp::viewSelectedIDs( event );
+    BOOST_CHECK_EQUAL_COLLECTIONS( selection.begin(), selection.end(),
+                                   view.begin(), view.end( ));
+
+    // the vector keeps its memory for the next event
+    zeq::hbp::uint32_ts ids;
+    zeq::hbp::deserializeSelectedIDs( event, ids );
+    BOOST_CHECK( ids == selection );
+    const uint32_t* data = ids.data();
+
+    const zeq::hbp::uint32_ts smaller( 10, 42 );
+    zeq::hbp::deserializeToggleIDRequest(
+        zeq::hbp::serializeToggleIDRequest( smaller ), ids );
+    BOOST_CHECK( ids == smaller );
+    BOOST_CHECK_EQUAL( ids.data(), data );
+
+    const zeq::hbp::uint32_ts empty;
+    const zeq::Event& emptyEvent = zeq::hbp::serializeSelectedIDs( empty );
+    BOOST_CHECK( zeq::hbp::viewSelectedIDs( emptyEvent ).empty( ));
+    zeq::hbp::deserializeSelectedIDs( emptyEvent, ids );
+    BOOST_CHECK( ids.empty( ));
+}
+
+BOOST_AUTO_TEST_CASE( viewsAndReuse )
+{
+    const std::vector< float > camera( 16, 42 );
+    const zeq::Event& cameraEvent = zeq::hbp::serializeCamera( camera );
+    const zeq::hbp::data::Span< float > matrix =
+        zeq::hbp::viewCamera( cameraEvent );
+    BOOST_CHECK_EQUAL_COLLECTIONS( camera.begin(), camera.end(),
+                                   matrix.begin(), matrix.end( ));
+    std::vector< float > deserializedCamera;
+    zeq::hbp::deserializeCamera( cameraEvent, deserializedCamera );
+    BOOST_CHECK( deserializedCamera == camera );
+
+    const std::vector< uint8_t > lut( 1024, 7 );
+    const zeq::Event& lutEvent = zeq::hbp::serializeLookupTable1D( lut );
+    BOOST_CHECK_EQUAL( zeq::hbp::viewLookupTable1D( lutEvent ).size(), 1024 );
+    std::vector< uint8_t > deserializedLut;
+    zeq::hbp::deserializeLookupTable1D( lutEvent, deserializedLut );
+    BOOST_CHECK( deserializedLut == lut );
+
+    const zeq::hbp::data::CellSetBinaryOp cellSet(
+        { 0, 2, 4, 6 }, { 1, 3, 5 }, zeq::hbp::CELLSETOP_SYNAPTIC_PROJECTIONS );
+    const zeq::Event& cellSetEvent =
+        zeq::hbp::serializeCellSetBinaryOp( cellSet );
+    const zeq::hbp::data::CellSetBinaryOpView view =
+        zeq::hbp::viewCellSetBinaryOp( cellSetEvent );
+    BOOST_CHECK_EQUAL_COLLECTIONS( cellSet.first.begin(), cellSet.first.end(),
+                                   view.first.begin(), view.first.end( ));
+    BOOST_CHECK_EQUAL_COLLECTIONS( cellSet.second.begin(),
+                                   cellSet.second.end(),
+                                   view.second.begin(), view.second.end( ));
+    BOOST_CHECK_EQUAL( view.operation, cellSet.operation );
+
+    zeq::hbp::data::CellSetBinaryOp deserialized;
+    zeq::hbp::deserializeCellSetBinaryOp( cellSetEvent, deserialized );
+    BOOST_CHECK( deserialized.first == cellSet.first );
+    BOOST_CHECK( deserialized.second == cellSet.second );
+    BOOST_CHECK_EQUAL( deserialized.operation, cellSet.operation );
+}
+
+BOOST_AUTO_TEST_CASE( idSets )
+{
+    zeq::hbp::data::IDSet selection;
+    selection.add( 1000, 500000 );
+    selection.add( 600000 );
+    const zeq::Event& event = zeq::hbp::serializeSelectedIDRanges( selection );
+    BOOST_CHECK_EQUAL( event.getType(), zeq::hbp::EVENT_SELECTEDIDRANGES );
+    BOOST_CHECK_LT( event.getSize(), 100 );
+
+    zeq::hbp::data::IDSet ids;
+    zeq::hbp::deserializeSelectedIDs( event, ids );
+    BOOST_CHECK( ids == selection );
+
+    // sets are filled from plain IDs as well
+    const zeq::hbp::uint32_ts plain = { 5, 3, 4, 10 };
+    zeq::hbp::deserializeSelectedIDs(
+        zeq::hbp::serializeSelectedIDs( plain ), ids );
+    BOOST_CHECK( ids == zeq::hbp::data::IDSet( plain ));
+
+    const zeq::Event& toggleEvent =
+        zeq::hbp::serializeToggleIDRangeRequest( selection );
+    BOOST_CHECK_EQUAL( toggleEvent.getType(),
+                       zeq::hbp::EVENT_TOGGLEIDRANGEREQUEST );
+    zeq::hbp::deserializeToggleIDRequest( toggleEvent, ids );
+    BOOST_CHECK( ids == selection );
+
+    zeq::hbp::deserializeToggleIDRequest(
+        zeq::hbp::serializeToggleIDRequest( plain ), ids );
+    BOOST_CHECK( ids == zeq::hbp::data::IDSet( plain ));
+
+    const zeq::Event& cellSetEvent = zeq::hbp::serializeCellSetBinaryOpRanges(
+        selection, zeq::hbp::data::IDSet( plain ),
+        zeq::hbp::CELLSETOP_SYNAPTIC_PROJECTIONS );
+    BOOST_CHECK_EQUAL( cellSetEvent.getType(),
+                       zeq::hbp::EVENT_CELLSETBINARYOPRANGES );
+    zeq::hbp::data::IDSet first, second;
+    zeq::hbp::CellSetBinaryOpType operation;
+    zeq::hbp::deserializeCellSetBinaryOp( cellSetEvent, first, second,
+                                          operation );
+    BOOST_CHECK( first == selection );
+    BOOST_CHECK( second == zeq::hbp::data::IDSet( plain ));
+    BOOST_CHECK_EQUAL( operation, zeq::hbp::CELLSETOP_SYNAPTIC_PROJECTIONS );
+
+    const zeq::Event& plainCellSetEvent =
+        zeq::hbp::serializeCellSetBinaryOp( plain, selection.toIDs(),
+                                            operation );
+    zeq::hbp::deserializeCellSetBinaryOp( plainCellSetEvent, first, second,
+                                          operation );
+    BOOST_CHECK( first == zeq::hbp::data::IDSet( plain ));
+    BOOST_CHECK( second == selection );
+    BOOST_CHECK_EQUAL( operation, zeq::hbp::CELLSETOP_SYNAPTIC_PROJECTIONS );
+}
+
+BOOST_AUTO_TEST_CASE( serializeInPlace )
+{
+    const zeq::Event& event = zeq::hbp::serializeSelectedIDs( 100000,
+        []( uint32_t* ids, const size_t size )
+        {
+            for( size_t i = 0; i < size; ++i )
+                ids[i] = uint32_t( i * 2 );
+        });
+    const zeq::hbp::uint32_ts& ids = zeq::hbp::deserializeSelectedIDs( event );
+    BOOST_REQUIRE_EQUAL( ids.size(), 100000 );
+    BOOST_CHECK_EQUAL( ids[0], 0 );
+    BOOST_CHECK_EQUAL( ids[99999], 199998 );
+
+    const zeq::hbp::uint32_ts toggled =
+        zeq::hbp::deserializeToggleIDRequest(
+            zeq::hbp::serializeToggleIDRequest( 0,
+                []( uint32_t*, size_t ) { BOOST_FAIL( "nothing to write" ); }));
+    BOOST_CHECK( toggled.empty( ));
+
+    const zeq::Event& lutEvent = zeq::hbp::serializeLookupTable1D(
+        []( uint8_t* lut, const size_t size )
+        {
+            BOOST_CHECK_EQUAL( size, 1024 );
+            ::memset( lut, 7, size );
+        });
+    BOOST_CHECK( zeq::hbp::deserializeLookupTable1D( lutEvent ) ==
+                 std::vector< uint8_t >( 1024, 7 ));
+
+    const uint8_t jpeg[] = { 0xFF, 0xD8, 0xFF, 0xD9 };
+    const zeq::Event& imageEvent = zeq::hbp::serializeImageJPEG( sizeof( jpeg ),
+        [&jpeg]( uint8_t* data, const size_t size )
+        {
+            ::memcpy( data, jpeg, size );
+        });
+    const zeq::hbp::data::ImageJPEG& image =
+        zeq::hbp::deserializeImageJPEG( imageEvent );
+    BOOST_CHECK_EQUAL_COLLECTIONS( jpeg, jpeg + sizeof( jpeg ),
+                                   image.getDataPtr(),
+                                   image.getDataPtr() + image.getSizeInBytes());
+}
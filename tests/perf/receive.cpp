@@ -0,0 +1,103 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#define BOOST_TEST_MODULE zeq_perf_receive
+
+#include "../broker.h"
+#include <zeq/connection/broker.h>
+#include <zeq/connection/service.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#ifndef _WIN32
+#  include <sys/resource.h>
+#endif
+
+using namespace zeq::vocabulary;
+
+namespace
+{
+// Each publisher has its own ZeroMQ context, using a few file descriptors
+size_t getMaxPublishers()
+{
+#ifdef _WIN32
+    return 100;
+#else
+    rlimit limit;
+    if( getrlimit( RLIMIT_NOFILE, &limit ) != 0 )
+        return 100;
+    return limit.rlim_cur / 8;
+#endif
+}
+}
+
+BOOST_AUTO_TEST_CASE(receive_scaling)
+{
+    const size_t numEvents = 1000;
+    const zeq::Event& event = serializeEcho( test::echoMessage );
+
+    for( size_t numPublishers = 1; numPublishers <= 1000; numPublishers *= 10 )
+    {
+        if( numPublishers > getMaxPublishers( ))
+        {
+            BOOST_TEST_MESSAGE( "Skip " << numPublishers << " publishers, "
+                                "not enough file descriptors" );
+            break;
+        }
+
+        std::vector< std::unique_ptr< zeq::Publisher > > publishers;
+        for( size_t i = 0; i < numPublishers; ++i )
+            publishers.emplace_back( new zeq::Publisher( zeq::NULL_SESSION ));
+
+        size_t received = 0;
+        zeq::Subscriber subscriber( test::buildURI( "127.0.0.1",
+                                                    *publishers.front( )));
+        BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                            [&received]( const zeq::Event& ) { ++received; }));
+
+        // Connect the other publishers through a broker served by receive
+        zeq::connection::Broker broker( "127.0.0.1:0", subscriber );
+        const std::string address = broker.getAddress();
+        std::atomic< bool > connected( false );
+        std::thread connector( [&]
+        {
+            for( size_t i = 1; i < publishers.size(); ++i )
+                zeq::connection::Service::subscribe( address, *publishers[i] );
+            connected = true;
+        });
+        while( !connected )
+            subscriber.receive( 10 );
+        connector.join();
+
+        zeq::Publisher& publisher = *publishers.back();
+        for( size_t i = 0; i < 50 && !publisher.hasSubscribers( EVENT_ECHO );
+             ++i )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+        }
+        BOOST_REQUIRE( publisher.hasSubscribers( EVENT_ECHO ));
+
+        // Round trips from the last publisher while all others are idle
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        for( size_t i = 0; i < numEvents; ++i )
+        {
+            BOOST_CHECK( publisher.publish( event ));
+            BOOST_CHECK( subscriber.receive( 1000 ));
+        }
+        const auto time = std::chrono::high_resolution_clock::now() -
+                          startTime;
+
+        BOOST_CHECK_EQUAL( received, numEvents );
+        BOOST_TEST_MESSAGE( numPublishers << " publishers: " <<
+                            std::chrono::duration_cast<
+                                std::chrono::microseconds >( time ).count() /
+                            numEvents << " us per event" );
+
+        // The publishers need to be destroyed before the subscriber, see
+        // publish_receive_filters in ../pubSub.cpp
+        publishers.clear();
+    }
+}
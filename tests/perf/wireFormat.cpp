@@ -0,0 +1,64 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#define BOOST_TEST_MODULE zeq_perf_wire_format
+
+#include "../broker.h"
+
+#include <chrono>
+
+using namespace zeq::vocabulary;
+
+namespace
+{
+size_t numReceived = 0;
+void onCountedEvent( const zeq::Event& ) { ++numReceived; }
+
+std::chrono::nanoseconds benchmarkWireFormat( const zeq::WireFormat format,
+                                              const size_t numEvents )
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    publisher.setWireFormat( format );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                         std::bind( &onCountedEvent, std::placeholders::_1 )));
+
+    // Make sure we're connected
+    const zeq::Event& event = serializeEcho( test::echoMessage );
+    for( size_t i = 0; i < 20; ++i )
+    {
+        BOOST_CHECK( publisher.publish( event ));
+        if( subscriber.receive( 100 ))
+            break;
+    }
+
+    numReceived = 0;
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    for( size_t i = 0; i < numEvents; ++i )
+    {
+        BOOST_CHECK( publisher.publish( event ));
+        while( subscriber.receive( 0 )) /* NOP to drain */;
+    }
+    const auto& time = std::chrono::high_resolution_clock::now() - startTime;
+
+    // the publisher drops events when it is ahead by a full queue
+    while( subscriber.receive( 100 )) /* NOP to drain */;
+    BOOST_CHECK_GT( numReceived, 0 );
+    return time;
+}
+}
+
+BOOST_AUTO_TEST_CASE(wire_format_throughput)
+{
+    const size_t numEvents = 50000;
+    const std::chrono::nanoseconds twoFrames =
+        benchmarkWireFormat( zeq::FORMAT_TWO_FRAMES, numEvents );
+    const std::chrono::nanoseconds singleFrame =
+        benchmarkWireFormat( zeq::FORMAT_SINGLE_FRAME, numEvents );
+
+    BOOST_TEST_MESSAGE( "Small events/s, two frames: " <<
+                        numEvents * 1000000000ull / twoFrames.count() <<
+                        ", single frame: " <<
+                        numEvents * 1000000000ull / singleFrame.count( ));
+}
@@ -0,0 +1,56 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#define BOOST_TEST_MODULE zeq_perf_zero_copy
+
+#include "../broker.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace zeq::vocabulary;
+
+namespace
+{
+const size_t numEvents = 1000;
+}
+
+BOOST_AUTO_TEST_CASE(publish_zero_copy)
+{
+    // The publisher needs to be destroyed before the subscriber, see
+    // publish_receive_filters in pubSub.cpp
+    zeq::Publisher* publisher = new zeq::Publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( zeq::URI( publisher->getURI( )));
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                       std::bind( &test::onEchoEvent, std::placeholders::_1 )));
+    for( size_t i = 0; i < 20 && !publisher->hasSubscribers( EVENT_ECHO ); ++i)
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+    BOOST_REQUIRE( publisher->hasSubscribers( EVENT_ECHO ));
+
+    // Only the publish calls are timed, the payloads are received by the
+    // subscriber's I/O thread in the background.
+    const zeq::Event& event = serializeEcho( std::string( 1 << 20, 'a' ));
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for( size_t i = 0; i < numEvents; ++i )
+        BOOST_CHECK( publisher->publish( event ));
+    const auto& copyTime = std::chrono::high_resolution_clock::now() -
+                           startTime;
+
+    publisher->setZeroCopy( true );
+    startTime = std::chrono::high_resolution_clock::now();
+    for( size_t i = 0; i < numEvents; ++i )
+        BOOST_CHECK( publisher->publish( event ));
+    const auto& zeroCopyTime = std::chrono::high_resolution_clock::now() -
+                               startTime;
+
+    BOOST_TEST_MESSAGE( "Publish 1 MB, zero copy: " <<
+                        std::chrono::nanoseconds( zeroCopyTime ).count() /
+                        numEvents << " ns, copy: " <<
+                        std::chrono::nanoseconds( copyTime ).count() /
+                        numEvents << " ns" );
+    BOOST_CHECK_MESSAGE( zeroCopyTime < copyTime,
+                         std::chrono::nanoseconds( zeroCopyTime ).count() <<
+                         ", " << std::chrono::nanoseconds( copyTime ).count( ));
+    delete publisher;
+}
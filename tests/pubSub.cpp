@@ -12,8 +12,10 @@
 #include <servus/servus.h>
 #include <servus/uri.h>
 
+#include <atomic>
 #include <thread>
 #include <chrono>
+#include <cstring>
 
 using namespace zeq::vocabulary;
 
@@ -40,6 +42,366 @@ BOOST_AUTO_TEST_CASE(publish_receive)
     BOOST_CHECK( received );
 }
 
+void onLargeEchoEvent( const zeq::Event& event, const std::string& expected )
+{
+    BOOST_CHECK_EQUAL( deserializeEcho( event ), expected );
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_zero_copy)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    const std::string message( 1 << 20, 'a' );
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                          std::bind( &onLargeEchoEvent, std::placeholders::_1,
+                                     std::cref( message ))));
+    publisher.setZeroCopy( true );
+
+    bool received = false;
+    for( size_t i = 0; i < 10; ++i )
+    {
+        // event goes out of scope while ZeroMQ may still send it
+        BOOST_CHECK( publisher.publish( serializeEcho( message )));
+
+        if( subscriber.receive( 100 ))
+        {
+            received = true;
+            break;
+        }
+    }
+    BOOST_CHECK( received );
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_single_frame)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    publisher.setWireFormat( zeq::FORMAT_SINGLE_FRAME );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                       std::bind( &test::onEchoEvent, std::placeholders::_1 )));
+    BOOST_CHECK( subscriber.registerHandler( EVENT_EXIT,
+                       std::bind( &test::onExitEvent, std::placeholders::_1 )));
+
+    bool received = false;
+    for( size_t i = 0; i < 10; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        BOOST_CHECK( publisher.publish( zeq::Event( EVENT_EXIT )));
+
+        if( subscriber.receive( 100 ))
+        {
+            received = true;
+            break;
+        }
+    }
+    BOOST_CHECK( received );
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_compressed)
+{
+    BOOST_CHECK( zeq::Publisher::isAvailable( zeq::COMPRESSION_NONE ));
+
+    for( const zeq::Compression compression :
+             { zeq::COMPRESSION_LZ4, zeq::COMPRESSION_ZSTD })
+    {
+        zeq::Publisher publisher( zeq::NULL_SESSION );
+        if( !zeq::Publisher::isAvailable( compression ))
+        {
+            BOOST_CHECK_THROW( publisher.setCompression( EVENT_ECHO,
+                                                         compression ),
+                               std::runtime_error );
+            continue;
+        }
+
+        publisher.setCompression( EVENT_ECHO, compression, 4096 );
+        zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+        // compressible, but below detail::MAX_COMPRESSION_RATIO
+        std::string message( 1 << 20, 'a' );
+        uint32_t random = 0;
+        for( char& c : message )
+        {
+            random = random * 1103515245u + 12345u;
+            c = char( 'a' + ( random >> 16 ) % 4 );
+        }
+        BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                          std::bind( &onLargeEchoEvent, std::placeholders::_1,
+                                     std::cref( message ))));
+
+        bool received = false;
+        for( size_t i = 0; i < 10; ++i )
+        {
+            BOOST_CHECK( publisher.publish( serializeEcho( message )));
+
+            if( subscriber.receive( 100 ))
+            {
+                received = true;
+                break;
+            }
+        }
+        BOOST_CHECK( received );
+
+        const zeq::Publisher::Stats& sent = publisher.getStats();
+        const zeq::Subscriber::Stats& stats = subscriber.getStats();
+        BOOST_CHECK_GT( sent.compressed, 0 );
+        BOOST_CHECK_LT( sent.compressedBytes, sent.uncompressedBytes );
+        BOOST_CHECK_EQUAL( stats.decompressed, 1 );
+        BOOST_CHECK_LT( stats.compressedBytes, stats.decompressedBytes );
+        BOOST_TEST_MESSAGE( "Compression ratio " <<
+                            double( sent.uncompressedBytes ) /
+                            double( sent.compressedBytes ) << ", " <<
+                            sent.compressionTime / sent.compressed <<
+                            " us per event" );
+    }
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_async)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    publisher.enableAsync( 128, zeq::OVERFLOW_DROP_OLDEST );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                       std::bind( &test::onEchoEvent, std::placeholders::_1 )));
+
+    bool received = false;
+    for( size_t i = 0; i < 10 && !received; ++i )
+    {
+        std::thread thread( [&publisher]
+            { publisher.publish( serializeEcho( test::echoMessage )); });
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        thread.join();
+
+        received = subscriber.receive( 100 );
+    }
+    BOOST_CHECK( received );
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_lazy)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                       std::bind( &test::onEchoEvent, std::placeholders::_1 )));
+
+    size_t numProduced = 0;
+    const zeq::EventProducer producer = [&numProduced]
+    {
+        ++numProduced;
+        return serializeEcho( test::echoMessage );
+    };
+
+    bool received = false;
+    for( size_t i = 0; i < 20 && !received; ++i )
+    {
+        BOOST_CHECK( publisher.publish( EVENT_ECHO, producer ));
+        received = subscriber.receive( 100 );
+    }
+    BOOST_CHECK( received );
+    BOOST_CHECK( publisher.hasSubscribers( EVENT_ECHO ));
+    BOOST_CHECK( !publisher.hasSubscribers( EVENT_EXIT ));
+    BOOST_CHECK_GT( numProduced, 0 );
+
+    // nobody listens to exit events
+    BOOST_CHECK( publisher.publish( EVENT_EXIT, []
+    {
+        BOOST_CHECK( !"reachable" );
+        return zeq::Event( EVENT_EXIT );
+    }));
+}
+
+void testLastValue( zeq::Publisher& publisher )
+{
+    publisher.setLastValueCache( EVENT_ECHO, true );
+    BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+
+    // the subscriber joins after the only publish, the publisher stays idle
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    size_t first = 0;
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+        [&first]( const zeq::Event& event )
+        {
+            BOOST_CHECK_EQUAL( deserializeEcho( event ), test::echoMessage );
+            ++first;
+        }));
+    BOOST_CHECK( subscriber.receive( 5000 ));
+    BOOST_CHECK_EQUAL( first, 1 );
+
+    // only a new subscriber receives the replay
+    zeq::Subscriber late( zeq::URI( publisher.getURI( )));
+    size_t second = 0;
+    BOOST_CHECK( late.registerHandler( EVENT_ECHO,
+        [&second]( const zeq::Event& ) { ++second; } ));
+    BOOST_CHECK( late.receive( 5000 ));
+    BOOST_CHECK_EQUAL( second, 1 );
+    BOOST_CHECK( !subscriber.receive( 200 ));
+    BOOST_CHECK_EQUAL( first, 1 );
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_last_value)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    testLastValue( publisher );
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_last_value_async)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    publisher.enableAsync();
+    testLastValue( publisher );
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_conflated)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    std::vector< std::string > received;
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+        [&received]( const zeq::Event& event )
+            { received.push_back( deserializeEcho( event )); },
+        zeq::DELIVER_LATEST ));
+
+    for( size_t i = 0; i < 20 && received.empty(); ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( "connect" )));
+        subscriber.receive( 100 );
+    }
+    BOOST_REQUIRE( !received.empty( ));
+    while( subscriber.receive( 100 )) {}
+    received.clear();
+
+    for( size_t i = 0; i < 10; ++i )
+        BOOST_CHECK( publisher.publish(
+                         serializeEcho( std::to_string( i ))));
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+
+    BOOST_CHECK( subscriber.receive( 100 ));
+    BOOST_REQUIRE_EQUAL( received.size(), 1 );
+    BOOST_CHECK_EQUAL( received[0], "9" );
+}
+
+BOOST_AUTO_TEST_CASE(publish_receive_multiple_handlers)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    size_t first = 0;
+    size_t second = 0;
+    const zeq::HandlerToken token = subscriber.addHandler( EVENT_ECHO,
+        [&first]( const zeq::Event& ) { ++first; } );
+    BOOST_CHECK( subscriber.addHandler( EVENT_ECHO,
+        [&second]( const zeq::Event& ) { ++second; } ) != token );
+    BOOST_CHECK( !subscriber.registerHandler( EVENT_ECHO,
+        []( const zeq::Event& ) {} ));
+    // all handlers of a type share the delivery mode
+    BOOST_CHECK_EQUAL( subscriber.addHandler( EVENT_ECHO,
+        []( const zeq::Event& ) {}, zeq::DELIVER_LATEST ), 0 );
+
+    for( size_t i = 0; i < 20 && first == 0; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( "connect" )));
+        subscriber.receive( 100 );
+    }
+    BOOST_REQUIRE_GT( first, 0 );
+    BOOST_CHECK_EQUAL( first, second );
+
+    BOOST_CHECK( subscriber.removeHandler( token ));
+    BOOST_CHECK( !subscriber.removeHandler( token ));
+    BOOST_CHECK( subscriber.hasHandler( EVENT_ECHO ));
+    while( subscriber.receive( 100 )) {}
+    first = second = 0;
+
+    BOOST_CHECK( publisher.publish( serializeEcho( "again" )));
+    BOOST_CHECK( subscriber.receive( 1000 ));
+    BOOST_CHECK_EQUAL( first, 0 );
+    BOOST_CHECK_EQUAL( second, 1 );
+
+    BOOST_CHECK( subscriber.deregisterHandler( EVENT_ECHO ));
+    BOOST_CHECK( !subscriber.hasHandler( EVENT_ECHO ));
+}
+
+BOOST_AUTO_TEST_CASE(modify_handlers_during_dispatch)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    size_t calls = 0;
+    size_t removedCalls = 0;
+    zeq::HandlerToken removed = 0;
+    zeq::HandlerToken self = 0;
+    std::vector< zeq::HandlerToken > added;
+
+    // The first handler adds handlers for enough types to grow the dispatch
+    // table, and removes itself and the following handler
+    self = subscriber.addHandler( EVENT_ECHO,
+        [&]( const zeq::Event& event )
+        {
+            ++calls;
+            for( uint64_t i = 1; i <= 64; ++i )
+                added.push_back( subscriber.addHandler(
+                    zeq::uint128_t( i, i ), []( const zeq::Event& ) {} ));
+            BOOST_CHECK( subscriber.removeHandler( self ));
+            BOOST_CHECK( subscriber.removeHandler( removed ));
+            BOOST_CHECK_EQUAL( deserializeEcho( event ), "connect" );
+        });
+    removed = subscriber.addHandler( EVENT_ECHO,
+        [&removedCalls]( const zeq::Event& ) { ++removedCalls; } );
+
+    for( size_t i = 0; i < 20 && calls == 0; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( "connect" )));
+        subscriber.receive( 100 );
+    }
+    BOOST_CHECK_EQUAL( calls, 1 );
+    BOOST_CHECK_EQUAL( removedCalls, 0 );
+    BOOST_CHECK( !subscriber.hasHandler( EVENT_ECHO ));
+    BOOST_CHECK_EQUAL( added.size(), 64 );
+    for( const zeq::HandlerToken token : added )
+        BOOST_CHECK( subscriber.removeHandler( token ));
+}
+
+BOOST_AUTO_TEST_CASE(publish_collect)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    BOOST_CHECK( subscriber.subscribe( EVENT_ECHO ));
+    BOOST_CHECK( !subscriber.subscribe( EVENT_ECHO ));
+    BOOST_CHECK( subscriber.subscribe( EVENT_REQUEST ));
+
+    zeq::EventBatch batch;
+    for( size_t i = 0; i < 20 && batch.empty(); ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( "connect" )));
+        subscriber.collect( batch, 100 );
+    }
+    BOOST_REQUIRE( !batch.empty( ));
+    while( subscriber.collect( batch, 100 ) > 0 ) {}
+    batch.clear();
+
+    for( size_t i = 0; i < 10; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( std::to_string( i ))));
+        BOOST_CHECK( publisher.publish( serializeRequest( EVENT_ECHO )));
+    }
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+
+    BOOST_CHECK_EQUAL( subscriber.collect( batch, EVENT_ECHO, 100 ), 10 );
+    BOOST_REQUIRE_EQUAL( batch.size(), 10 );
+    for( size_t i = 0; i < batch.size(); ++i )
+    {
+        const zeq::Event expected = serializeEcho( std::to_string( i ));
+        BOOST_CHECK_EQUAL( batch.getType( i ), EVENT_ECHO );
+        BOOST_REQUIRE_EQUAL( batch.getSize( i ), expected.getSize( ));
+        BOOST_CHECK_EQUAL( ::memcmp( batch.getData( i ), expected.getData(),
+                                     expected.getSize( )), 0 );
+    }
+
+    // the requests were kept for the next collect
+    batch.clear();
+    BOOST_CHECK_EQUAL( subscriber.collect( batch ), 10 );
+    for( size_t i = 0; i < batch.size(); ++i )
+        BOOST_CHECK_EQUAL( batch.getType( i ), EVENT_REQUEST );
+
+    BOOST_CHECK( subscriber.unsubscribe( EVENT_ECHO ));
+    BOOST_CHECK( !subscriber.unsubscribe( EVENT_ECHO ));
+}
+
 BOOST_AUTO_TEST_CASE(no_receive)
 {
     zeq::Subscriber subscriber( zeq::URI( "1.2.3.4:1234" ));
@@ -295,6 +657,35 @@ BOOST_AUTO_TEST_CASE(publish_blocking_receive_zeroconf)
     thread.join( );
 }
 
+BOOST_AUTO_TEST_CASE(discovery_wakes_up_blocking_receive_zeroconf)
+{
+    if( !servus::Servus::isAvailable() || getenv("TRAVIS"))
+        return;
+
+    zeq::Subscriber subscriber( test::buildUniqueSession( ));
+    zeq::detail::Sender::getUUID() = servus::make_UUID(); // different machine
+    BOOST_CHECK( subscriber.registerHandler( EVENT_ECHO,
+                       std::bind( &test::onEchoEvent, std::placeholders::_1 )));
+
+    // The publisher appears while receive() blocks, which only connects to it
+    // if the discovery wakes it up
+    std::atomic< bool > running( true );
+    std::thread thread( [&subscriber, &running]
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 200 ));
+        zeq::Publisher publisher( subscriber.getSession( ));
+        while( running )
+        {
+            publisher.publish( serializeEcho( test::echoMessage ));
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ));
+        }
+    });
+
+    BOOST_CHECK( subscriber.receive( 10000 ));
+    running = false;
+    thread.join();
+}
+
 #ifdef ZEQ_USE_ZEROBUF
 BOOST_AUTO_TEST_CASE(publish_receive_zerobuf)
 {
@@ -14,6 +14,9 @@
 
 #include <servus/servus.h>
 
+#include <chrono>
+#include <thread>
+
 BOOST_AUTO_TEST_CASE(create_uri_publisher)
 {
     const zeq::Publisher publisher( zeq::URI( "" ));
@@ -64,6 +67,121 @@ BOOST_AUTO_TEST_CASE(publish_empty_event)
     BOOST_CHECK( publisher.publish( zeq::Event( zeq::vocabulary::EVENT_EXIT )));
 }
 
+BOOST_AUTO_TEST_CASE(publish_without_subscribers)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    BOOST_CHECK( !publisher.hasSubscribers( zeq::vocabulary::EVENT_ECHO ));
+
+    bool produced = false;
+    BOOST_CHECK( publisher.publish( zeq::vocabulary::EVENT_ECHO,
+        [&produced]
+        {
+            produced = true;
+            return zeq::vocabulary::serializeEcho( test::echoMessage );
+        }));
+    BOOST_CHECK( !produced );
+}
+
+namespace
+{
+void publishEchos( zeq::Publisher& publisher, const size_t numEvents )
+{
+    for( size_t i = 0; i < numEvents; ++i )
+        publisher.publish( zeq::vocabulary::serializeEcho( test::echoMessage ));
+}
+
+void waitForSubscriber( const zeq::Publisher& publisher )
+{
+    for( size_t i = 0; i < 20; ++i )
+    {
+        if( publisher.hasSubscribers( zeq::vocabulary::EVENT_ECHO ))
+            return;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+    }
+    BOOST_FAIL( "Subscription did not arrive" );
+}
+}
+
+BOOST_AUTO_TEST_CASE(publish_async)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    publisher.enableAsync( 16, zeq::OVERFLOW_DROP_NEWEST );
+    BOOST_CHECK_THROW( publisher.enableAsync(), std::runtime_error );
+
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                       std::bind( &test::onEchoEvent, std::placeholders::_1 )));
+    waitForSubscriber( publisher );
+
+    const size_t numThreads = 4;
+    const size_t numEvents = 10000;
+    std::vector< std::thread > threads;
+    for( size_t i = 0; i < numThreads; ++i )
+        threads.push_back( std::thread( std::bind( &publishEchos,
+                                                   std::ref( publisher ),
+                                                   numEvents )));
+    for( std::thread& thread : threads )
+        thread.join();
+
+    zeq::Publisher::Stats stats = publisher.getStats();
+    for( size_t i = 0; i < 100 && stats.queueDepth > 0; ++i )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ));
+        stats = publisher.getStats();
+    }
+    BOOST_CHECK_EQUAL( stats.queueDepth, 0 );
+    BOOST_CHECK_EQUAL( stats.sent + stats.dropped, numThreads * numEvents );
+}
+
+BOOST_AUTO_TEST_CASE(publish_async_drop_oldest)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    publisher.enableAsync( 16, zeq::OVERFLOW_DROP_OLDEST );
+
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                       std::bind( &test::onEchoEvent, std::placeholders::_1 )));
+    waitForSubscriber( publisher );
+
+    const size_t numThreads = 4;
+    const size_t numEvents = 10000;
+    std::vector< std::thread > threads;
+    for( size_t i = 0; i < numThreads; ++i )
+        threads.push_back( std::thread( std::bind( &publishEchos,
+                                                   std::ref( publisher ),
+                                                   numEvents )));
+    for( std::thread& thread : threads )
+        thread.join();
+
+    zeq::Publisher::Stats stats = publisher.getStats();
+    for( size_t i = 0; i < 100 && stats.queueDepth > 0; ++i )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ));
+        stats = publisher.getStats();
+    }
+    BOOST_CHECK_EQUAL( stats.queueDepth, 0 );
+    BOOST_CHECK_EQUAL( stats.sent + stats.dropped, numThreads * numEvents );
+}
+
+BOOST_AUTO_TEST_CASE(publish_async_block)
+{
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    publisher.enableAsync( 16, zeq::OVERFLOW_BLOCK );
+
+    zeq::Subscriber subscriber( zeq::URI( publisher.getURI( )));
+    BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                       std::bind( &test::onEchoEvent, std::placeholders::_1 )));
+    waitForSubscriber( publisher );
+
+    std::thread thread( std::bind( &publishEchos, std::ref( publisher ),
+                                   10000 ));
+    publishEchos( publisher, 10000 );
+    thread.join();
+
+    BOOST_CHECK_GT( publisher.getStats().sent, 0 );
+    BOOST_CHECK_EQUAL( publisher.getStats().dropped, 0 );
+}
+
 BOOST_AUTO_TEST_CASE(multiple_publisher_on_same_host)
 {
     if( !servus::Servus::isAvailable() || getenv("TRAVIS"))
@@ -7,7 +7,15 @@
 
 #include "broker.h"
 
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#ifndef _WIN32
+#  include <poll.h>
+#endif
 
 bool gotOne = false;
 bool gotTwo = false;
@@ -89,3 +97,244 @@ BOOST_AUTO_TEST_CASE(test_publisher_routing)
     testReceive( publisher, subscriber2, gotTwo, __LINE__ );
     BOOST_CHECK( !gotOne );
 }
+
+BOOST_AUTO_TEST_CASE(test_reentrant_receive)
+{
+    using zeq::vocabulary::serializeEcho;
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber1( test::buildURI( "localhost", publisher ));
+    zeq::Subscriber subscriber2( test::buildURI( "localhost", publisher ),
+                                 subscriber1 );
+
+    // handlers of one poll receive again from the group, which processes the
+    // sockets signalled by the nested poll
+    size_t depth = 0;
+    size_t received = 0;
+    const auto handler = [&]( const zeq::Event& )
+    {
+        ++received;
+        if( depth > 0 )
+            return;
+        ++depth;
+        while( subscriber1.receive( 100 )) {}
+        --depth;
+    };
+    BOOST_CHECK( subscriber1.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                                              handler ));
+    BOOST_CHECK( subscriber2.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                                              handler ));
+
+    for( size_t i = 0; i < 20 && received == 0; ++i )
+    {
+        for( size_t j = 0; j < 10; ++j )
+        {
+            BOOST_CHECK( publisher.publish(
+                             serializeEcho( test::echoMessage )));
+        }
+        subscriber1.receive( 100 );
+    }
+    BOOST_CHECK_GT( received, 1 );
+}
+
+BOOST_AUTO_TEST_CASE(test_drain)
+{
+    using zeq::vocabulary::serializeEcho;
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( test::buildURI( "localhost", publisher ));
+    size_t received = 0;
+    BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                            [&received]( const zeq::Event& ) { ++received; }));
+
+    for( size_t i = 0; i < 20 && received == 0; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        subscriber.receive( 100 );
+    }
+    BOOST_REQUIRE_GT( received, 0u );
+    while( subscriber.drain( 100, 0 ) > 0 ) {}
+
+    for( size_t i = 0; i < 10; ++i )
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+
+    received = 0;
+    BOOST_CHECK_EQUAL( subscriber.drain( 100, 4 ), 4u );
+    BOOST_CHECK_EQUAL( received, 4u );
+    BOOST_CHECK_EQUAL( subscriber.drain( 100, 0 ), 6u );
+    BOOST_CHECK_EQUAL( received, 10u );
+    BOOST_CHECK_EQUAL( subscriber.drain( 100, 0, 1000 ), 0u );
+}
+
+BOOST_AUTO_TEST_CASE(test_start_stop)
+{
+    using zeq::vocabulary::serializeEcho;
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( test::buildURI( "localhost", publisher ));
+    std::atomic< bool > received( false );
+    BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                        [&received]( const zeq::Event& ) { received = true; }));
+
+    BOOST_CHECK( !subscriber.isRunning( ));
+    subscriber.start();
+    BOOST_CHECK( subscriber.isRunning( ));
+    BOOST_CHECK_THROW( subscriber.start(), std::runtime_error );
+
+    for( size_t i = 0; i < 20 && !received; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+    }
+    BOOST_CHECK( received );
+
+    subscriber.stop();
+    BOOST_CHECK( !subscriber.isRunning( ));
+    subscriber.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_leave_running_group)
+{
+    using zeq::vocabulary::serializeEcho;
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( test::buildURI( "localhost", publisher ));
+    std::atomic< size_t > received( 0 );
+    BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                        [&received]( const zeq::Event& ) { ++received; }));
+    std::unique_ptr< zeq::Subscriber > member(
+        new zeq::Subscriber( test::buildURI( "localhost", publisher ),
+                             subscriber ));
+    BOOST_CHECK( member->registerHandler( zeq::vocabulary::EVENT_ECHO,
+                        [&received]( const zeq::Event& ) { ++received; }));
+
+    subscriber.start();
+    BOOST_CHECK_THROW( zeq::Subscriber( test::buildURI( "localhost",
+                                                        publisher ),
+                                        subscriber ),
+                       std::runtime_error );
+
+    for( size_t i = 0; i < 20 && received == 0; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+    }
+    BOOST_CHECK( received > 0 );
+
+    // the thread continues with the remaining subscriber
+    member.reset();
+    BOOST_CHECK( subscriber.isRunning( ));
+    received = 0;
+    for( size_t i = 0; i < 20 && received == 0; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+    }
+    BOOST_CHECK( received > 0 );
+    subscriber.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_start_executor)
+{
+    using zeq::vocabulary::serializeEcho;
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( test::buildURI( "localhost", publisher ));
+    bool received = false;
+    BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                            [&received]( const zeq::Event& event )
+                            {
+                                test::onEchoEvent( event );
+                                received = true;
+                            }));
+
+    // handlers are queued by the receive thread and run here
+    std::mutex mutex;
+    std::deque< zeq::Task > tasks;
+    subscriber.start( [&]( const zeq::Task& task )
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        tasks.push_back( task );
+    });
+
+    for( size_t i = 0; i < 20 && !received; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+
+        std::deque< zeq::Task > pending;
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            pending.swap( tasks );
+        }
+        for( const zeq::Task& task : pending )
+            task();
+    }
+    BOOST_CHECK( received );
+    subscriber.stop();
+}
+
+BOOST_AUTO_TEST_CASE(test_executor_outlives_subscriber)
+{
+    using zeq::vocabulary::serializeEcho;
+    using zeq::vocabulary::deserializeEcho;
+    // larger than the inline payload of events, received in place
+    const std::string message( 4096, 'a' );
+    std::mutex mutex;
+    std::deque< zeq::Task > tasks;
+    std::string received;
+    {
+        zeq::Publisher publisher( zeq::NULL_SESSION );
+        zeq::Subscriber subscriber( test::buildURI( "localhost", publisher ));
+        BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                                [&received]( const zeq::Event& event )
+                                { received = deserializeEcho( event ); }));
+        subscriber.start( [&]( const zeq::Task& task )
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            tasks.push_back( task );
+        });
+
+        for( size_t i = 0; i < 20; ++i )
+        {
+            BOOST_CHECK( publisher.publish( serializeEcho( message )));
+            std::this_thread::sleep_for( std::chrono::milliseconds( 100 ));
+            std::lock_guard< std::mutex > lock( mutex );
+            if( !tasks.empty( ))
+                break;
+        }
+        subscriber.stop();
+    }
+
+    // the queued events own copies of their payloads
+    BOOST_REQUIRE( !tasks.empty( ));
+    for( const zeq::Task& task : tasks )
+        task();
+    BOOST_CHECK_EQUAL( received, message );
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(test_file_descriptors)
+{
+    using zeq::vocabulary::serializeEcho;
+    zeq::Publisher publisher( zeq::NULL_SESSION );
+    zeq::Subscriber subscriber( test::buildURI( "localhost", publisher ));
+    bool received = false;
+    BOOST_CHECK( subscriber.registerHandler( zeq::vocabulary::EVENT_ECHO,
+                        [&received]( const zeq::Event& ) { received = true; }));
+
+    const zeq::FileDescriptors& descriptors = subscriber.getFileDescriptors();
+    BOOST_REQUIRE( !descriptors.empty( ));
+    std::vector< pollfd > fds;
+    for( const zeq::FileDescriptor descriptor : descriptors )
+    {
+        const pollfd fd = { descriptor, POLLIN, 0 };
+        fds.push_back( fd );
+    }
+
+    BOOST_CHECK_EQUAL( subscriber.processReady(), 0u );
+    for( size_t i = 0; i < 20 && !received; ++i )
+    {
+        BOOST_CHECK( publisher.publish( serializeEcho( test::echoMessage )));
+        if( ::poll( fds.data(), fds.size(), 100 ) > 0 )
+            subscriber.processReady();
+    }
+    BOOST_CHECK( received );
+}
+#endif
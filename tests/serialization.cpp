@@ -17,6 +17,9 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <thread>
+
 BOOST_AUTO_TEST_CASE(vocabulary_serialization)
 {
     zeq::EventDescriptors vocabulary;
@@ -101,6 +104,38 @@ BOOST_AUTO_TEST_CASE(serialization)
     BOOST_CHECK_EQUAL( message, deserialized );
 }
 
+BOOST_AUTO_TEST_CASE(reuse_builders)
+{
+    const void* data = nullptr;
+    {
+        const zeq::Event& event = zeq::vocabulary::serializeEcho( "first" );
+        data = event.getData();
+    }
+    // The builder returned to the pool and is reused with its buffer
+    const zeq::Event& event = zeq::vocabulary::serializeEcho( "again" );
+    BOOST_CHECK_EQUAL( event.getData(), data );
+    BOOST_CHECK_EQUAL( zeq::vocabulary::deserializeEcho( event ), "again" );
+
+    const zeq::Event empty( zeq::vocabulary::EVENT_ECHO );
+    BOOST_CHECK_EQUAL( empty.getSize(), 0 );
+
+    // released by another thread, e.g., after a zero-copy send, the builder
+    // returns to the pool of this thread
+    {
+        zeq::Event* other = new zeq::Event(
+            zeq::vocabulary::serializeEcho( "other" ));
+        data = other->getData();
+        std::thread( [other] { delete other; } ).join();
+    }
+    const zeq::Event& returned = zeq::vocabulary::serializeEcho( "moved" );
+    BOOST_CHECK_EQUAL( returned.getData(), data );
+
+    // the built data stays valid once the event has a parser
+    zeq::Event built = zeq::vocabulary::serializeEcho( "built" );
+    built.getParser();
+    BOOST_CHECK_EQUAL( zeq::vocabulary::deserializeEcho( built ), "built" );
+}
+
 BOOST_AUTO_TEST_CASE(json_serialization)
 {
     const std::string json( "{\n"
@@ -112,6 +147,77 @@ BOOST_AUTO_TEST_CASE(json_serialization)
     BOOST_CHECK_EQUAL( json, deserialized );
 }
 
+BOOST_AUTO_TEST_CASE(json_serialization_threads)
+{
+    const std::string json( "{\n"
+                            "  \"message\": \"test message\"\n"
+                            "}\n" );
+    std::atomic< size_t > failures( 0 );
+    std::vector< std::thread > threads;
+    for( size_t i = 0; i < 4; ++i )
+    {
+        threads.push_back( std::thread( [&]
+        {
+            // the output string is reused for each conversion
+            std::string deserialized;
+            for( size_t j = 0; j < 100; ++j )
+            {
+                const zeq::Event& event = zeq::vocabulary::serializeJSON(
+                    zeq::vocabulary::EVENT_ECHO, json );
+                zeq::vocabulary::deserializeJSON( event, deserialized );
+                if( deserialized != json )
+                    ++failures;
+            }
+        }));
+    }
+    for( std::thread& thread : threads )
+        thread.join();
+    BOOST_CHECK_EQUAL( failures.load(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE(json_register_while_converting)
+{
+    const std::string json( "{\n"
+                            "  \"message\": \"test message\"\n"
+                            "}\n" );
+    const std::string schema = "table Test { message:string; } root_type Test;";
+    std::atomic< bool > running( true );
+    std::atomic< size_t > failures( 0 );
+    std::thread converter( [&]
+    {
+        std::string deserialized;
+        while( running )
+        {
+            const zeq::Event& event = zeq::vocabulary::serializeJSON(
+                zeq::vocabulary::EVENT_ECHO, json );
+            zeq::vocabulary::deserializeJSON( event, deserialized );
+            if( deserialized != json )
+                ++failures;
+        }
+    });
+
+    for( uint64_t i = 0; i < 100; ++i )
+        zeq::vocabulary::registerEvent( zeq::uint128_t( 1000, i ), schema );
+    running = false;
+    converter.join();
+    BOOST_CHECK_EQUAL( failures.load(), 0 );
+
+    const zeq::Event& event =
+        zeq::vocabulary::serializeJSON( zeq::uint128_t( 1000, 99 ), json );
+    BOOST_CHECK_EQUAL( zeq::vocabulary::deserializeJSON( event ), json );
+
+    // registering a type again replaces its schema
+    const std::string replacedJSON( "{\n"
+                                    "  \"text\": \"replaced\"\n"
+                                    "}\n" );
+    zeq::vocabulary::registerEvent( zeq::uint128_t( 1000, 99 ),
+                        "table Replaced { text:string; } root_type Replaced;" );
+    const zeq::Event& replaced = zeq::vocabulary::serializeJSON(
+        zeq::uint128_t( 1000, 99 ), replacedJSON );
+    BOOST_CHECK_EQUAL( zeq::vocabulary::deserializeJSON( replaced ),
+                       replacedJSON );
+}
+
 BOOST_AUTO_TEST_CASE(invalid_json_serialization)
 {
     const std::string json( "{\n"
@@ -114,6 +114,7 @@ Broker::Broker( const std::string& address, Receiver& receiver )
 
 Broker::~Broker()
 {
+    leaveGroup();
     delete _impl;
 }
 
@@ -122,9 +123,10 @@ void Broker::addSockets( std::vector< zeq::detail::Socket >& entries )
     _impl->addSockets( entries );
 }
 
-void Broker::process( zeq::detail::Socket& socket )
+size_t Broker::process( zeq::detail::Socket& socket )
 {
     _impl->process( socket );
+    return 1;
 }
 
 std::string Broker::getAddress() const
@@ -0,0 +1,137 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEQ_DETAIL_BOUNDEDQUEUE_H
+#define ZEQ_DETAIL_BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace zeq
+{
+namespace detail
+{
+
+/**
+ * A bounded, lock-free multi-producer single-consumer queue.
+ *
+ * Based on Dmitry Vyukov's bounded MPMC queue: each cell carries a sequence
+ * number which tells producers and the consumer whether the cell is free or
+ * filled for their current position. Producers claim positions atomically;
+ * pop() may only be called from one thread at a time and needs no atomic
+ * read-modify-write. Neither push() nor pop() block; they fail when the queue
+ * is full or empty, respectively.
+ */
+template< typename T > class BoundedQueue
+{
+public:
+    /** Create a queue for at least the given number of elements. */
+    explicit BoundedQueue( const size_t capacity )
+        : _mask( _roundUp( capacity ) - 1 )
+        , _cells( new Cell[ _mask + 1 ] )
+        , _pushPos( 0 )
+        , _popPos( 0 )
+    {
+        for( size_t i = 0; i <= _mask; ++i )
+            _cells[i].sequence.store( i, std::memory_order_relaxed );
+    }
+
+    /**
+     * Append a value to the queue.
+     *
+     * @return false if the queue is full, in which case value is untouched
+     */
+    bool push( T& value )
+    {
+        size_t pos = _pushPos.load( std::memory_order_relaxed );
+        for( ;; )
+        {
+            Cell& cell = _cells[ pos & _mask ];
+            const size_t sequence = cell.sequence.load(
+                                                   std::memory_order_acquire );
+            const intptr_t diff = intptr_t( sequence ) - intptr_t( pos );
+            if( diff == 0 )
+            {
+                if( _pushPos.compare_exchange_weak( pos, pos + 1,
+                                                  std::memory_order_relaxed ))
+                {
+                    cell.value = std::move( value );
+                    cell.sequence.store( pos + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if( diff < 0 )
+                return false;
+            else
+                pos = _pushPos.load( std::memory_order_relaxed );
+        }
+    }
+
+    /**
+     * Remove the oldest value from the queue, from the consumer thread only.
+     *
+     * @return false if the queue is empty, or the oldest value is still being
+     *         pushed
+     */
+    bool pop( T& value )
+    {
+        const size_t pos = _popPos.load( std::memory_order_relaxed );
+        Cell& cell = _cells[ pos & _mask ];
+        if( cell.sequence.load( std::memory_order_acquire ) != pos + 1 )
+            return false;
+
+        value = std::move( cell.value );
+        cell.sequence.store( pos + _mask + 1, std::memory_order_release );
+        _popPos.store( pos + 1, std::memory_order_relaxed );
+        return true;
+    }
+
+    /** @return the approximate number of queued values */
+    size_t size() const
+    {
+        const size_t popPos = _popPos.load( std::memory_order_relaxed );
+        const size_t pushPos = _pushPos.load( std::memory_order_relaxed );
+        return pushPos > popPos ? pushPos - popPos : 0;
+    }
+
+    /** @return the maximum number of queued values */
+    size_t capacity() const { return _mask + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic< size_t > sequence;
+        T value;
+    };
+
+    // Keep the producer and consumer positions on separate cache lines
+    typedef char Padding[64];
+
+    const size_t _mask;
+    std::unique_ptr< Cell[] > _cells;
+    Padding _pad0;
+    std::atomic< size_t > _pushPos;
+    Padding _pad1;
+    std::atomic< size_t > _popPos;
+    Padding _pad2;
+
+    static size_t _roundUp( const size_t capacity )
+    {
+        size_t size = 2;
+        while( size < capacity )
+            size <<= 1;
+        return size;
+    }
+
+    BoundedQueue( const BoundedQueue& ) = delete;
+    BoundedQueue& operator=( const BoundedQueue& ) = delete;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,76 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#include "bufferPool.h"
+
+#include <cstring>
+
+namespace zeq
+{
+namespace detail
+{
+namespace
+{
+// Upper bounds for idle buffers, additional ones are freed on release
+const size_t MAX_BUFFERS = 64;
+const size_t MAX_BUFFER_SIZE = 16 * 1024 * 1024;
+const size_t MAX_POOL_SIZE = 64 * 1024 * 1024;
+}
+
+BufferPool& BufferPool::getInstance()
+{
+    // Never destroyed, pooled buffers may be released during static
+    // destruction.
+    static BufferPool* pool = new BufferPool;
+    return *pool;
+}
+
+std::shared_ptr< uint8_t > BufferPool::allocate( const size_t size )
+{
+    uint8_t* buffer = nullptr;
+    size_t capacity = size;
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        const Buffers::iterator i = _buffers.lower_bound( size );
+        if( i != _buffers.end() && i->first / 2 <= size )
+        {
+            capacity = i->first;
+            buffer = i->second;
+            _size -= capacity;
+            _buffers.erase( i );
+        }
+    }
+    if( !buffer )
+        buffer = new uint8_t[ capacity ]; // not zero-filled, unlike a vector
+
+    return std::shared_ptr< uint8_t >( buffer,
+                                       [this, capacity]( uint8_t* ptr )
+                                       { _release( ptr, capacity ); });
+}
+
+ConstByteArray BufferPool::copy( const void* data, const size_t size )
+{
+    std::shared_ptr< uint8_t > buffer = allocate( size );
+    if( size > 0 )
+        ::memcpy( buffer.get(), data, size );
+    return buffer;
+}
+
+void BufferPool::_release( uint8_t* buffer, const size_t capacity )
+{
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        if( capacity <= MAX_BUFFER_SIZE && _buffers.size() < MAX_BUFFERS &&
+            _size + capacity <= MAX_POOL_SIZE )
+        {
+            _buffers.insert( std::make_pair( capacity, buffer ));
+            _size += capacity;
+            return;
+        }
+    }
+    delete [] buffer;
+}
+
+}
+}
@@ -0,0 +1,58 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_DETAIL_BUFFERPOOL_H
+#define ZEQ_DETAIL_BUFFERPOOL_H
+
+#include <zeq/types.h>
+
+#include <map>
+#include <mutex>
+
+namespace zeq
+{
+namespace detail
+{
+
+/**
+ * A thread-safe pool of reusable byte buffers.
+ *
+ * Buffers handed out by allocate() and copy() return to the pool once the
+ * last reference to them is released. Each allocation reuses the smallest idle
+ * buffer it fits in, if it does not waste more than half of it. The idle
+ * buffers are bounded in number and total size, large ones are freed.
+ */
+class BufferPool
+{
+public:
+    /** @return the process-wide buffer pool */
+    static BufferPool& getInstance();
+
+    /**
+     * @return a pooled buffer of the given size, not initialized, to be filled
+     *         by the caller
+     */
+    std::shared_ptr< uint8_t > allocate( size_t size );
+
+    /** @return a pooled copy of the given data */
+    ConstByteArray copy( const void* data, size_t size );
+
+private:
+    // idle buffers by capacity, for best-fit reuse
+    typedef std::multimap< size_t, uint8_t* > Buffers;
+
+    std::mutex _mutex;
+    Buffers _buffers;
+    size_t _size; // of the idle buffers
+
+    BufferPool() : _size( 0 ) {}
+
+    void _release( uint8_t* buffer, size_t capacity );
+};
+
+}
+}
+
+#endif
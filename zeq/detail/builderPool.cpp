@@ -0,0 +1,205 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#include "builderPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace zeq
+{
+namespace detail
+{
+namespace
+{
+// Upper bound for idle builders per thread, additional ones are freed
+const size_t MAX_BUILDERS = 16;
+// Initial size of builders for types without a size hint yet
+const size_t DEFAULT_SIZE = 1024;
+
+class Builder;
+
+/**
+ * Builders released by other threads, e.g., after a zero-copy send, for the
+ * pool of their owning thread. Outlives the pool if the owner exits first.
+ */
+struct Returns
+{
+    Returns() : pending( false ), closed( false ) {}
+
+    std::mutex mutex;
+    std::vector< std::pair< uint128_t, Builder* >> builders;
+    std::atomic< bool > pending; // builders is not empty
+    bool closed; // the owning pool is gone
+};
+typedef std::shared_ptr< Returns > ReturnsPtr;
+
+class Builder : public flatbuffers::FlatBufferBuilder
+{
+public:
+    Builder( const size_t size, const ReturnsPtr& owner_ )
+        : flatbuffers::FlatBufferBuilder( size )
+        , capacity( size )
+        , owner( owner_ )
+    {}
+
+    size_t capacity; // largest size built, the buffer holds at least that
+    const ReturnsPtr owner; // of the pool which allocated this builder
+};
+
+class Pool
+{
+public:
+    Pool() : _returns( std::make_shared< Returns >( )) {}
+
+    ~Pool()
+    {
+        for( Builder* builder : _idle )
+            delete builder;
+
+        std::lock_guard< std::mutex > lock( _returns->mutex );
+        for( const auto& returned : _returns->builders )
+            delete returned.second;
+        _returns->builders.clear();
+        _returns->closed = true;
+        _destroyed = true;
+    }
+
+    Builder* acquire( const uint128_t& type )
+    {
+        if( _returns->pending )
+            _takeReturns();
+
+        const auto i = _hints.find( type );
+        const size_t hint = i == _hints.end() ? DEFAULT_SIZE : i->second;
+
+        // take the smallest idle builder fitting the hint
+        auto best = _idle.end();
+        for( auto j = _idle.begin(); j != _idle.end(); ++j )
+        {
+            if( (*j)->capacity >= hint &&
+                ( best == _idle.end() || (*j)->capacity < (*best)->capacity ))
+            {
+                best = j;
+            }
+        }
+        if( best != _idle.end( ))
+        {
+            Builder* builder = *best;
+            *best = _idle.back();
+            _idle.pop_back();
+            return builder;
+        }
+
+        // Allocate the hinted size at once instead of growing a smaller
+        // builder step by step, which replaces the largest idle one.
+        if( _idle.size() >= MAX_BUILDERS )
+        {
+            auto largest = std::max_element( _idle.begin(), _idle.end(),
+                []( const Builder* a, const Builder* b )
+                    { return a->capacity < b->capacity; } );
+            delete *largest;
+            *largest = _idle.back();
+            _idle.pop_back();
+        }
+        return new Builder( hint, _returns );
+    }
+
+    void release( const uint128_t& type, Builder* builder )
+    {
+        const size_t size = builder->GetSize();
+        builder->capacity = std::max( builder->capacity, size );
+
+        // Follow the largest recent event, but let the hint decay towards
+        // smaller ones, so that one large event does not inflate all later
+        // builders of its type.
+        size_t& hint = _hints[ type ];
+        hint = size >= hint ? size : std::max( size, hint - hint / 8 );
+        hint = std::max( hint, DEFAULT_SIZE );
+
+        if( _idle.size() >= MAX_BUILDERS )
+        {
+            delete builder;
+            return;
+        }
+        builder->Clear(); // keeps the buffer
+        _idle.push_back( builder );
+    }
+
+    /** @return true if the builder was allocated by this pool */
+    bool owns( const Builder* builder ) const
+        { return builder->owner == _returns; }
+
+    /** @return true if the pool of this thread was destroyed on exit */
+    static bool isDestroyed() { return _destroyed; }
+
+    /** Hand a builder of another thread back to its pool. */
+    static void giveBack( const uint128_t& type, Builder* builder )
+    {
+        Returns& returns = *builder->owner;
+        {
+            std::lock_guard< std::mutex > lock( returns.mutex );
+            if( !returns.closed && returns.builders.size() < MAX_BUILDERS )
+            {
+                returns.builders.push_back( std::make_pair( type, builder ));
+                returns.pending = true;
+                return;
+            }
+        }
+        delete builder;
+    }
+
+private:
+    std::vector< Builder* > _idle;
+    std::unordered_map< uint128_t, size_t > _hints;
+    const ReturnsPtr _returns;
+    static thread_local bool _destroyed;
+
+    void _takeReturns()
+    {
+        std::vector< std::pair< uint128_t, Builder* >> returned;
+        {
+            std::lock_guard< std::mutex > lock( _returns->mutex );
+            returned.swap( _returns->builders );
+            _returns->pending = false;
+        }
+        for( const auto& i : returned )
+            release( i.first, i.second );
+    }
+};
+
+thread_local bool Pool::_destroyed = false;
+thread_local Pool _pool;
+}
+
+flatbuffers::FlatBufferBuilder* BuilderPool::acquire( const uint128_t& type )
+{
+    return _pool.acquire( type );
+}
+
+void BuilderPool::release( const uint128_t& type,
+                           flatbuffers::FlatBufferBuilder* ptr )
+{
+    // may be released by another thread, e.g., after a zero-copy send
+    Builder* builder = static_cast< Builder* >( ptr );
+    if( !Pool::isDestroyed() && _pool.owns( builder ))
+        _pool.release( type, builder );
+    else
+        Pool::giveBack( type, builder );
+}
+
+BuilderPool::BuilderPtr BuilderPool::share( const uint128_t& type,
+                                      flatbuffers::FlatBufferBuilder* builder )
+{
+    return BuilderPtr( builder, [type]( flatbuffers::FlatBufferBuilder* ptr )
+                                    { release( type, ptr ); });
+}
+
+}
+}
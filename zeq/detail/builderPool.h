@@ -0,0 +1,49 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_DETAIL_BUILDERPOOL_H
+#define ZEQ_DETAIL_BUILDERPOOL_H
+
+#include <zeq/types.h>
+
+#include <flatbuffers/flatbuffers.h>
+
+namespace zeq
+{
+namespace detail
+{
+
+/**
+ * Thread-local pools of reusable FlatBufferBuilders.
+ *
+ * Released builders return to the pool of the thread which acquired them,
+ * keeping their grown buffer. Builders released by another thread are queued
+ * for their owner. The pools remember the size of the recent large events per
+ * type, and hand out a builder which fits it without reallocation.
+ */
+class BuilderPool
+{
+public:
+    typedef std::shared_ptr< flatbuffers::FlatBufferBuilder > BuilderPtr;
+
+    /** @return an empty builder for an event of the given type */
+    static flatbuffers::FlatBufferBuilder* acquire( const uint128_t& type );
+
+    /** Return a builder from acquire() to the pool of its thread. */
+    static void release( const uint128_t& type,
+                         flatbuffers::FlatBufferBuilder* builder );
+
+    /**
+     * @return a shared builder from acquire(), released to the pool when
+     *         the last reference to it is gone
+     */
+    static BuilderPtr share( const uint128_t& type,
+                             flatbuffers::FlatBufferBuilder* builder );
+};
+
+}
+}
+
+#endif
@@ -26,6 +26,19 @@ namespace zeq
 namespace detail
 {
 
+inline void byteswap( uint32_t& value )
+{
+#ifdef _MSC_VER
+    value = _byteswap_ulong( value );
+#elif defined __xlC__
+    value = __bswap_constant_32( value );
+#elif defined USE_GCC_BSWAP_FUNCTION
+    value = bswap_32( value );
+#else
+    value = __builtin_bswap32( value );
+#endif
+}
+
 inline void byteswap( uint64_t& value )
 {
 #ifdef _MSC_VER
@@ -0,0 +1,126 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#include "compression.h"
+
+#ifdef ZEQ_USE_LZ4
+#  include <lz4.h>
+#endif
+#ifdef ZEQ_USE_ZSTD
+#  include <zstd.h>
+#endif
+
+namespace zeq
+{
+namespace detail
+{
+namespace
+{
+#ifdef ZEQ_USE_ZSTD
+// Favor speed, compression has to keep up with the network
+const int ZSTD_LEVEL = 1;
+#endif
+}
+
+bool isAvailable( const Compression compression )
+{
+    switch( compression )
+    {
+    case COMPRESSION_NONE:
+        return true;
+#ifdef ZEQ_USE_LZ4
+    case COMPRESSION_LZ4:
+        return true;
+#endif
+#ifdef ZEQ_USE_ZSTD
+    case COMPRESSION_ZSTD:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+size_t getMaxCompressedSize( const Compression compression, const size_t size )
+{
+    switch( compression )
+    {
+#ifdef ZEQ_USE_LZ4
+    case COMPRESSION_LZ4:
+        if( size > LZ4_MAX_INPUT_SIZE )
+            return 0;
+        return LZ4_compressBound( int( size ));
+#endif
+#ifdef ZEQ_USE_ZSTD
+    case COMPRESSION_ZSTD:
+        return ZSTD_compressBound( size );
+#endif
+    default:
+        (void)size;
+        return 0;
+    }
+}
+
+size_t compress( const Compression compression, const void* data,
+                 const size_t size, void* out, const size_t outSize )
+{
+    switch( compression )
+    {
+#ifdef ZEQ_USE_LZ4
+    case COMPRESSION_LZ4:
+    {
+        if( size > LZ4_MAX_INPUT_SIZE )
+            return 0;
+        const int result = LZ4_compress_default(
+            static_cast< const char* >( data ), static_cast< char* >( out ),
+            int( size ), int( outSize ));
+        return result > 0 ? size_t( result ) : 0;
+    }
+#endif
+#ifdef ZEQ_USE_ZSTD
+    case COMPRESSION_ZSTD:
+    {
+        const size_t result = ZSTD_compress( out, outSize, data, size,
+                                             ZSTD_LEVEL );
+        return ZSTD_isError( result ) ? 0 : result;
+    }
+#endif
+    default:
+        (void)data; (void)size; (void)out; (void)outSize;
+        return 0;
+    }
+}
+
+bool decompress( const Compression compression, const void* data,
+                 const size_t size, void* out, const size_t outSize )
+{
+    switch( compression )
+    {
+#ifdef ZEQ_USE_LZ4
+    case COMPRESSION_LZ4:
+    {
+        if( size > LZ4_MAX_INPUT_SIZE || outSize > LZ4_MAX_INPUT_SIZE )
+            return false;
+        const int result = LZ4_decompress_safe(
+            static_cast< const char* >( data ), static_cast< char* >( out ),
+            int( size ), int( outSize ));
+        return result >= 0 && size_t( result ) == outSize;
+    }
+#endif
+#ifdef ZEQ_USE_ZSTD
+    case COMPRESSION_ZSTD:
+    {
+        const size_t result = ZSTD_decompress( out, outSize, data, size );
+        return !ZSTD_isError( result ) && result == outSize;
+    }
+#endif
+    default:
+        (void)data; (void)size; (void)out; (void)outSize;
+        return false;
+    }
+}
+
+}
+}
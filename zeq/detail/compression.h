@@ -0,0 +1,55 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_DETAIL_COMPRESSION_H
+#define ZEQ_DETAIL_COMPRESSION_H
+
+#include <zeq/types.h>
+
+namespace zeq
+{
+namespace detail
+{
+
+/**
+ * Header frame of a compressed event: the type as for uncompressed events,
+ * followed by the codec (uint32_t) and the uncompressed size (uint64_t) in
+ * little endian. The compressed payload is in the second frame.
+ */
+const size_t COMPRESSED_HEADER_SIZE = sizeof( uint128_t ) + sizeof( uint32_t ) +
+                                      sizeof( uint64_t );
+
+/**
+ * Upper bound of uncompressed / compressed size. The uncompressed size in the
+ * header is untrusted, it must not make a subscriber allocate more than this
+ * multiple of the received payload. Publishers send data that compresses
+ * better uncompressed.
+ */
+const size_t MAX_COMPRESSION_RATIO = 1024;
+
+/** @return true if zeq was built with the given codec */
+bool isAvailable( Compression compression );
+
+/** @return the buffer size needed to compress the given number of bytes */
+size_t getMaxCompressedSize( Compression compression, size_t size );
+
+/**
+ * Compress the given data.
+ * @return the compressed size, 0 if the data could not be compressed
+ */
+size_t compress( Compression compression, const void* data, size_t size,
+                 void* out, size_t outSize );
+
+/**
+ * Decompress the given data.
+ * @return true if exactly outSize bytes were decompressed
+ */
+bool decompress( Compression compression, const void* data, size_t size,
+                 void* out, size_t outSize );
+
+}
+}
+
+#endif
@@ -23,6 +23,11 @@ const std::string UNKNOWN_USER( "Unknown user" );
 
 const std::string DEFAULT_SCHEMA( "tcp" );
 
+// Subscription topic asking for the last value of a type: an identifier of the
+// subscriber followed by the type. Publishers send the cached value with this
+// topic in place of the type, so that only the new subscriber receives it.
+const size_t REPLAY_TOPIC_SIZE = 32;
+
 }
 
 #endif
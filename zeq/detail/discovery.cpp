@@ -0,0 +1,243 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#include "discovery.h"
+#include "broker.h"
+#include "constants.h"
+
+#include <zeq/log.h>
+
+#include <servus/servus.h>
+#include <zmq.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <thread>
+
+namespace zeq
+{
+namespace detail
+{
+namespace
+{
+// A servus browser cannot be interrupted, this is the maximum delay to notice
+// publisher changes and to stop the thread
+const int32_t BROWSE_INTERVAL = 250; // ms
+
+// Delay before browsing again if zeroconf fails, e.g., without a daemon
+const std::chrono::seconds RETRY_INTERVAL( 1 );
+
+std::string getZmqURI( const std::string& instance )
+{
+    const size_t pos = instance.find( ":" );
+    const std::string& host = instance.substr( 0, pos );
+    const std::string& port = instance.substr( pos + 1 );
+
+    return buildZmqURI( DEFAULT_SCHEMA, host, std::stoi( port ));
+}
+
+template< typename T > void erase( std::vector< T >& vector, const T& value )
+{
+    vector.erase( std::remove( vector.begin(), vector.end(), value ),
+                  vector.end( ));
+}
+}
+
+/**
+ * Browses zeroconf in one thread for all discoveries of the process.
+ *
+ * The thread runs while discoveries exist. It leaves when the last one is
+ * removed, without the discovery waiting for it; it is joined before the next
+ * thread starts or when the process exits.
+ */
+class Browser
+{
+public:
+    static Browser& getInstance()
+    {
+        static Browser browser;
+        return browser;
+    }
+
+    ~Browser()
+    {
+        {
+            std::lock_guard< std::mutex > lock( _mutex );
+            _stopping = true;
+        }
+        if( _thread.joinable( ))
+            _thread.join();
+    }
+
+    void add( Discovery* discovery )
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _discoveries.push_back( discovery );
+
+        Discovery::Publishers announced;
+        for( const auto& i : _announced )
+            announced.push_back( i.second );
+        if( !announced.empty( ))
+            discovery->_update( announced, Discovery::URIs( ));
+
+        if( _running )
+            return;
+
+        // the previous thread has left, it only needs to finish
+        if( _thread.joinable( ))
+            _thread.join();
+        _announced.clear();
+        _running = true;
+        _thread = std::thread( std::bind( &Browser::_run, this ));
+    }
+
+    /** The discovery is not used anymore once this returns */
+    void remove( Discovery* discovery )
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        erase( _discoveries, discovery );
+    }
+
+private:
+    Browser() : _running( false ), _stopping( false ) {}
+
+    typedef std::map< std::string, Discovery::Publisher > Announced;
+
+    std::mutex _mutex;
+    std::vector< Discovery* > _discoveries;
+    Announced _announced; // by zeroconf instance name
+    bool _running; // the thread has not decided to leave yet
+    bool _stopping; // the process exits
+    std::thread _thread;
+
+    void _run()
+    {
+        servus::Servus browser( PUBLISHER_SERVICE );
+        for( ;; )
+        {
+            if(( !browser.isBrowsing() &&
+                 !browser.beginBrowsing( servus::Servus::IF_ALL )) ||
+               !browser.browse( BROWSE_INTERVAL ))
+            {
+                std::this_thread::sleep_for( RETRY_INTERVAL );
+            }
+
+            std::lock_guard< std::mutex > lock( _mutex );
+            if( _stopping || _discoveries.empty( ))
+            {
+                _running = false;
+                break;
+            }
+            if( browser.isBrowsing( ))
+                _update( browser );
+        }
+
+        if( browser.isBrowsing( ))
+            browser.endBrowsing();
+    }
+
+    /** Compare the announced instances to the last ones, notify changes */
+    void _update( const servus::Servus& browser )
+    {
+        Announced announced;
+        Discovery::Publishers added;
+        for( const std::string& instance : browser.getInstances( ))
+        {
+            const Announced::const_iterator i = _announced.find( instance );
+            if( i != _announced.end( ))
+            {
+                announced.insert( *i );
+                continue;
+            }
+
+            Discovery::Publisher publisher;
+            publisher.uri = getZmqURI( instance );
+            publisher.hasSession = browser.containsKey( instance, KEY_SESSION );
+            publisher.session = browser.get( instance, KEY_SESSION );
+            publisher.instance =
+                uint128_t( browser.get( instance, KEY_INSTANCE ));
+            announced.insert( std::make_pair( instance, publisher ));
+            added.push_back( publisher );
+        }
+
+        Discovery::URIs removed;
+        for( const auto& i : _announced )
+        {
+            if( announced.count( i.first ) == 0 )
+                removed.push_back( i.second.uri );
+        }
+
+        _announced.swap( announced );
+        if( added.empty() && removed.empty( ))
+            return;
+
+        for( Discovery* discovery : _discoveries )
+            discovery->_update( added, removed );
+    }
+};
+
+Discovery::Discovery( void* context, const std::string& wakeupURI )
+    : _wakeup( zmq_socket( context, ZMQ_PUSH ))
+{
+    const int linger = 0;
+    zmq_setsockopt( _wakeup, ZMQ_LINGER, &linger, sizeof( linger ));
+    if( zmq_connect( _wakeup, wakeupURI.c_str( )) == -1 )
+    {
+        const std::string error = zmq_strerror( zmq_errno( ));
+        zmq_close( _wakeup );
+        ZEQTHROW( std::runtime_error( "Cannot connect discovery to " +
+                                      wakeupURI + ": " + error ));
+    }
+    Browser::getInstance().add( this );
+}
+
+Discovery::~Discovery()
+{
+    Browser::getInstance().remove( this );
+    zmq_close( _wakeup );
+}
+
+Discovery::Publishers Discovery::takePublishers()
+{
+    Publishers publishers;
+    std::lock_guard< std::mutex > lock( _mutex );
+    publishers.swap( _publishers );
+    return publishers;
+}
+
+Discovery::URIs Discovery::takeRemoved()
+{
+    URIs removed;
+    std::lock_guard< std::mutex > lock( _mutex );
+    removed.swap( _removed );
+    return removed;
+}
+
+void Discovery::_update( const Publishers& added, const URIs& removed )
+{
+    {
+        // Only the last change of a publisher not taken yet counts
+        std::lock_guard< std::mutex > lock( _mutex );
+        for( const std::string& uri : removed )
+        {
+            _publishers.erase( std::remove_if( _publishers.begin(),
+                                               _publishers.end(),
+                [&uri]( const Publisher& publisher )
+                    { return publisher.uri == uri; }), _publishers.end( ));
+            _removed.push_back( uri );
+        }
+        for( const Publisher& publisher : added )
+        {
+            erase( _removed, publisher.uri );
+            _publishers.push_back( publisher );
+        }
+    }
+    // one pending wakeup is enough, don't block if the receiver is busy
+    zmq_send( _wakeup, 0, 0, ZMQ_DONTWAIT );
+}
+
+}
+}
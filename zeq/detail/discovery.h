@@ -0,0 +1,77 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_DETAIL_DISCOVERY_H
+#define ZEQ_DETAIL_DISCOVERY_H
+
+#include <zeq/types.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace zeq
+{
+namespace detail
+{
+
+class Browser;
+
+/**
+ * Discovers publishers on zeroconf for one receiver.
+ *
+ * One browser thread per process browses zeroconf while discoveries exist. It
+ * queues appearing and disappearing publishers for all discoveries, and wakes
+ * up their receiving threads by a message to the given inproc socket address.
+ * The receivers thus block in their poll until publishers change instead of
+ * browsing periodically.
+ */
+class Discovery
+{
+public:
+    /** A publisher announced on zeroconf */
+    struct Publisher
+    {
+        std::string uri; //!< ZeroMQ address of the publisher
+        std::string session; //!< empty if not announced
+        bool hasSession; //!< the session was announced
+        uint128_t instance; //!< identifier of the publishing application
+    };
+    typedef std::vector< Publisher > Publishers;
+    typedef std::vector< std::string > URIs;
+
+    /**
+     * Start discovering publishers, including the ones announced right now.
+     *
+     * @param context the ZeroMQ context of the receiving thread
+     * @param wakeupURI inproc address to notify on new publishers
+     */
+    Discovery( void* context, const std::string& wakeupURI );
+
+    /** Stop discovering, does not wait for the browser thread. */
+    ~Discovery();
+
+    /** @return the publishers found since the last call. */
+    Publishers takePublishers();
+
+    /** @return the addresses of publishers gone since the last call. */
+    URIs takeRemoved();
+
+private:
+    friend class Browser;
+
+    void* _wakeup; // used by the browser, serialized by its mutex
+
+    std::mutex _mutex;
+    Publishers _publishers;
+    URIs _removed;
+
+    /** Queue changed publishers and wake up the receiver */
+    void _update( const Publishers& added, const URIs& removed );
+};
+
+}
+}
+
+#endif
@@ -1,6 +1,6 @@
 
-/* Copyright (c) 2014, Human Brain Project
- *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+/* Copyright (c) 2014-2016, Human Brain Project
+ *                          Daniel Nachbaur <daniel.nachbaur@epfl.ch>
  */
 
 #ifndef ZEQ_DETAIL_EVENT_H
@@ -10,8 +10,14 @@
 #include <zeq/event.h>
 #include <zeq/log.h>
 
+#include "bufferPool.h"
+#include "builderPool.h"
+
 #include <flatbuffers/flatbuffers.h>
 #include <flatbuffers/idl.h>
+#include <zmq.h>
+
+#include <cstring>
 
 namespace zeq
 {
@@ -26,36 +32,174 @@ static inline void dummy_deleter( const void* ) {}
 class Event
 {
 public:
+    /** Payloads up to this size are stored in the event, see setData() */
+    static const size_t INLINE_SIZE = 256;
+
+    /** Alignment of the largest FlatBuffers scalar, see setData() */
+    static const size_t ALIGNMENT = sizeof( uint64_t );
+
     explicit Event( const uint128_t& type_ )
         : type( type_ )
         , size( 0 )
+        , _builder( nullptr )
+        , _offset( 0 )
+        , _hasMessage( false )
+        , _isInline( false )
     {}
 
+    ~Event()
+    {
+        _clearBuilder();
+    }
+
+    /**
+     * Events come from a thread-local free list, so that constructing one,
+     * e.g., for each received message, does not allocate in steady state.
+     */
+    static void* operator new( size_t bytes );
+    static void operator delete( void* ptr );
+
     size_t getSize() const
     {
-        if( data )
+        if( data || _hasMessage || _isInline )
             return size;
-        return parser.builder_.GetSize();
+        if( _useParser( ))
+            return _parser->builder_.GetSize();
+        return _builder ? _builder->GetSize() : 0;
     }
 
     const void* getData() const
     {
+        if( _isInline )
+            return _inline;
+        if( _hasMessage )
+            return _getMessageData();
         if( data )
             return data.get();
-        return parser.builder_.GetBufferPointer();
+        if( _useParser( ))
+            return _parser->builder_.GetBufferPointer();
+        return _builder ? _builder->GetBufferPointer() : nullptr;
+    }
+
+    /** @return the builder to serialize the event, from the builder pool */
+    flatbuffers::FlatBufferBuilder& getFBB()
+    {
+        if( _parser )
+            return _parser->builder_;
+        if( !_builder )
+            _builder = BuilderPool::acquire( type );
+        return *_builder;
+    }
+
+    /**
+     * @return the parser for JSON conversion, serializing into its own
+     *         builder. Created on first use, only the JSON paths need it.
+     */
+    flatbuffers::Parser& getParser()
+    {
+        if( !_parser )
+        {
+            // an event built already keeps its data until the parser builds
+            if( _builder && _builder->GetSize() == 0 )
+                _releaseBuilder();
+            _parser.reset( new flatbuffers::Parser );
+        }
+        return *_parser;
+    }
+
+    /** @return the serialized data, keeping its owner alive while in use */
+    ConstByteArray getSharedData() const
+    {
+        if( _isInline )
+            return BufferPool::getInstance().copy( _inline, size );
+        if( _hasMessage )
+        {
+            // shares the message content with ZeroMQ, no data copy
+            zmq_msg_t* message = new zmq_msg_t;
+            zmq_msg_init( message );
+            zmq_msg_copy( message, &_message );
+            return ConstByteArray(
+                static_cast< const uint8_t* >( zmq_msg_data( message )) +
+                    _offset,
+                [message]( const uint8_t* )
+                {
+                    zmq_msg_close( message );
+                    delete message;
+                });
+        }
+        if( data )
+            return data;
+        if( _useParser( ))
+            return ConstByteArray( _parser,
+                                   _parser->builder_.GetBufferPointer( ));
+        if( !_builder )
+            return ConstByteArray();
+
+        // shared from now on, the owner releases it to the builder pool
+        if( !_sharedBuilder )
+            _sharedBuilder = BuilderPool::share( type, _builder );
+        return ConstByteArray( _sharedBuilder, _builder->GetBufferPointer( ));
     }
 
     void setData( const ConstByteArray& data_, const size_t size_ )
     {
-        parser.builder_.Clear();
+        _clearBuilder();
         data = data_;
         size = size_;
     }
 
-    const uint128_t type;
+    /**
+     * Take ownership of a received message and use its data from the given
+     * offset on in place. Small payloads are copied into the event instead,
+     * which releases the message right away. So are payloads which are not
+     * aligned for FlatBuffers, e.g., behind a header in the same frame, which
+     * are copied to a pooled buffer.
+     */
+    void setData( zmq_msg_t& message, const size_t offset )
+    {
+        _clearBuilder();
+        data.reset();
 
-    /** store the serialized data in here */
-    flatbuffers::Parser parser;
+        const uint8_t* payload =
+            static_cast< const uint8_t* >( zmq_msg_data( &message )) + offset;
+        size = zmq_msg_size( &message ) - offset;
+        if( size <= INLINE_SIZE )
+        {
+            ::memcpy( _inline, payload, size );
+            _isInline = true;
+            return;
+        }
+
+        if( reinterpret_cast< uintptr_t >( payload ) % ALIGNMENT != 0 )
+        {
+            data = BufferPool::getInstance().copy( payload, size );
+            return;
+        }
+
+        zmq_msg_init( &_message );
+        zmq_msg_move( &_message, &message );
+        _offset = offset;
+        _hasMessage = true;
+    }
+
+    /**
+     * Copy the data of a received message to a pooled buffer and release the
+     * message.
+     *
+     * Needed when the event is retained beyond its dispatch, since ZeroMQ may
+     * back many small messages with one shared receive buffer, which stays
+     * allocated as long as any of its messages is alive.
+     */
+    void detach()
+    {
+        if( !_hasMessage )
+            return;
+
+        data = BufferPool::getInstance().copy( _getMessageData(), size );
+        _closeMessage();
+    }
+
+    const uint128_t type;
 
     /** setData() uses this instead of fbb during deserialization */
     ConstByteArray data;
@@ -64,6 +208,62 @@ public:
 private:
     Event( const Event& ) = delete;
     Event& operator=( const Event& ) = delete;
+
+    /**
+     * Store the serialized data in one of these, both created on demand. The
+     * pooled builder is owned by _sharedBuilder once shared with zero-copy
+     * sends, which may still be in flight when the event is destroyed.
+     */
+    mutable flatbuffers::FlatBufferBuilder* _builder;
+    mutable BuilderPool::BuilderPtr _sharedBuilder;
+    std::shared_ptr< flatbuffers::Parser > _parser;
+
+    /** received message, owned if _hasMessage is set */
+    mutable zmq_msg_t _message;
+    size_t _offset;
+    bool _hasMessage;
+
+    /** small received payload, valid if _isInline is set */
+    uint64_t _inline[ INLINE_SIZE / sizeof( uint64_t ) ];
+    bool _isInline;
+
+    /** @return true if the data is in the parser's builder */
+    bool _useParser() const
+    {
+        return _parser && ( !_builder || _parser->builder_.GetSize() > 0 );
+    }
+
+    const uint8_t* _getMessageData() const
+    {
+        return static_cast< const uint8_t* >( zmq_msg_data( &_message )) +
+               _offset;
+    }
+
+    void _releaseBuilder()
+    {
+        if( _sharedBuilder )
+            _sharedBuilder.reset();
+        else if( _builder )
+            BuilderPool::release( type, _builder );
+        _builder = nullptr;
+    }
+
+    void _clearBuilder()
+    {
+        _closeMessage();
+        _isInline = false;
+        _releaseBuilder();
+        if( _parser )
+            _parser->builder_.Clear();
+    }
+
+    void _closeMessage()
+    {
+        if( !_hasMessage )
+            return;
+        zmq_msg_close( &_message );
+        _hasMessage = false;
+    }
 };
 
 }
@@ -0,0 +1,151 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_DETAIL_FLATMAP_H
+#define ZEQ_DETAIL_FLATMAP_H
+
+#include <zeq/types.h>
+
+#include <utility>
+#include <vector>
+
+namespace zeq
+{
+namespace detail
+{
+
+/**
+ * An open-addressing hash map from event types to values.
+ *
+ * Uses linear probing in one contiguous array which is kept at most half full,
+ * so a lookup typically touches a single slot. Erasing shifts the following
+ * entries back instead of leaving tombstones. Pointers to values are
+ * invalidated by insertions and erasures.
+ */
+template< typename V > class FlatMap
+{
+public:
+    FlatMap() : _slots( 16 ), _size( 0 ) {}
+
+    /** @return the value of the given key, or nullptr if not found */
+    V* find( const uint128_t& key )
+    {
+        for( size_t i = _home( key ); _slots[i].used; i = _next( i ))
+        {
+            if( _slots[i].key == key )
+                return &_slots[i].value;
+        }
+        return nullptr;
+    }
+
+    const V* find( const uint128_t& key ) const
+    {
+        return const_cast< FlatMap* >( this )->find( key );
+    }
+
+    /** @return the value of the given key, inserted if not found */
+    V& operator[]( const uint128_t& key )
+    {
+        V* value = find( key );
+        if( value )
+            return *value;
+
+        if( 2 * ( _size + 1 ) > _slots.size( ))
+            _grow();
+
+        size_t i = _home( key );
+        while( _slots[i].used )
+            i = _next( i );
+
+        _slots[i].key = key;
+        _slots[i].used = true;
+        ++_size;
+        return _slots[i].value;
+    }
+
+    /** @return true if the key was found and erased */
+    bool erase( const uint128_t& key )
+    {
+        size_t i = _home( key );
+        while( _slots[i].used && _slots[i].key != key )
+            i = _next( i );
+        if( !_slots[i].used )
+            return false;
+
+        // Shift back entries of the probe sequence that would not be found
+        // anymore after freeing slot i
+        for( size_t j = _next( i ); _slots[j].used; j = _next( j ))
+        {
+            const size_t home = _home( _slots[j].key );
+            const bool between = i <= j ? ( i < home && home <= j )
+                                        : ( i < home || home <= j );
+            if( between )
+                continue;
+
+            _slots[i].key = _slots[j].key;
+            _slots[i].value = std::move( _slots[j].value );
+            i = j;
+        }
+
+        _slots[i] = Slot();
+        --_size;
+        return true;
+    }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    /** Call the given function with each key and value */
+    template< typename F > void forEach( const F& func ) const
+    {
+        for( const Slot& slot : _slots )
+        {
+            if( slot.used )
+                func( slot.key, slot.value );
+        }
+    }
+
+private:
+    struct Slot
+    {
+        Slot() : used( false ) {}
+
+        uint128_t key;
+        V value;
+        bool used;
+    };
+
+    std::vector< Slot > _slots; // size is a power of two
+    size_t _size;
+
+    size_t _home( const uint128_t& key ) const
+    {
+        // event types are hashes already, mix both halves for the index
+        const uint64_t hash = ( key.high() ^ key.low( )) *
+                              0x9E3779B97F4A7C15ull;
+        return size_t( hash >> 32 ) & ( _slots.size() - 1 );
+    }
+
+    size_t _next( const size_t i ) const
+    {
+        return ( i + 1 ) & ( _slots.size() - 1 );
+    }
+
+    void _grow()
+    {
+        std::vector< Slot > slots( _slots.size() * 2 );
+        slots.swap( _slots );
+        _size = 0;
+        for( Slot& slot : slots )
+        {
+            if( slot.used )
+                (*this)[ slot.key ] = std::move( slot.value );
+        }
+    }
+};
+
+}
+}
+
+#endif
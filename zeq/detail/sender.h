@@ -27,28 +27,34 @@ namespace detail
 
 class Sender
 {
-    void* _context; // must be private before socket
+    void* _ownContext; // must be private before socket
+    void* _context;
 
 public:
     Sender( void* context, const int type )
-        : _context( 0 )
-        , socket( zmq_socket( _createContext( context ), type ))
+        : _ownContext( 0 )
+        , _context( _createContext( context ))
+        , socket( zmq_socket( _context, type ))
     {}
 
     Sender( const URI& uri_, void* context, const int type )
-        : _context( 0 )
+        : _ownContext( 0 )
+        , _context( _createContext( context ))
         , uri( uri_ )
-        , socket( zmq_socket( _createContext( context ), type ))
+        , socket( zmq_socket( _context, type ))
     {}
 
     ~Sender()
     {
         if( socket )
             zmq_close( socket );
-        if( _context )
-            zmq_ctx_destroy( _context );
+        if( _ownContext )
+            zmq_ctx_destroy( _ownContext );
     }
 
+    /** @return the ZeroMQ context of the socket, e.g., for inproc sockets */
+    void* getContext() const { return _context; }
+
     std::string getAddress() const
     {
         return uri.getHost() + ":" + std::to_string( uint32_t( uri.getPort( )));
@@ -115,8 +121,8 @@ private:
         if( context )
             return context;
 
-        _context = zmq_ctx_new();
-        return _context;
+        _ownContext = zmq_ctx_new();
+        return _ownContext;
     }
 };
 
@@ -0,0 +1,147 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_DETAIL_SMALLVECTOR_H
+#define ZEQ_DETAIL_SMALLVECTOR_H
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace zeq
+{
+namespace detail
+{
+
+/**
+ * A vector storing up to N elements inline, without heap allocation.
+ *
+ * Grows into heap memory beyond N elements. Movable, not copyable. Only the
+ * subset of std::vector used by zeq is implemented.
+ */
+template< typename T, size_t N > class SmallVector
+{
+public:
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    SmallVector() : _data( _local( )), _size( 0 ), _capacity( N ) {}
+
+    SmallVector( SmallVector&& from )
+        : _data( _local( )), _size( 0 ), _capacity( N )
+    {
+        _take( from );
+    }
+
+    SmallVector& operator=( SmallVector&& from )
+    {
+        if( this != &from )
+        {
+            clear();
+            _free();
+            _take( from );
+        }
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        clear();
+        _free();
+    }
+
+    void push_back( const T& value )
+    {
+        if( _size == _capacity )
+            _grow();
+        new( _data + _size ) T( value );
+        ++_size;
+    }
+
+    iterator erase( const iterator pos )
+    {
+        std::move( pos + 1, end(), pos );
+        _data[ --_size ].~T();
+        return pos;
+    }
+
+    void clear()
+    {
+        for( size_t i = 0; i < _size; ++i )
+            _data[i].~T();
+        _size = 0;
+    }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    T& operator[]( const size_t i ) { return _data[i]; }
+    const T& operator[]( const size_t i ) const { return _data[i]; }
+
+private:
+    typedef typename std::aligned_storage< sizeof( T ),
+                                           alignof( T ) >::type Storage;
+    Storage _storage[N];
+    T* _data;
+    size_t _size;
+    size_t _capacity;
+
+    SmallVector( const SmallVector& ) = delete;
+    SmallVector& operator=( const SmallVector& ) = delete;
+
+    T* _local() { return reinterpret_cast< T* >( _storage ); }
+
+    void _grow()
+    {
+        T* data = static_cast< T* >( ::operator new( 2 * _capacity *
+                                                      sizeof( T )));
+        for( size_t i = 0; i < _size; ++i )
+        {
+            new( data + i ) T( std::move( _data[i] ));
+            _data[i].~T();
+        }
+        const size_t capacity = 2 * _capacity;
+        _free();
+        _data = data;
+        _capacity = capacity;
+    }
+
+    void _free()
+    {
+        if( _data != _local( ))
+            ::operator delete( _data );
+        _data = _local();
+        _capacity = N;
+    }
+
+    void _take( SmallVector& from )
+    {
+        if( from._data == from._local( ))
+        {
+            for( size_t i = 0; i < from._size; ++i )
+                new( _data + i ) T( std::move( from._data[i] ));
+            _size = from._size;
+            from.clear();
+            return;
+        }
+
+        _data = from._data;
+        _size = from._size;
+        _capacity = from._capacity;
+        from._data = from._local();
+        from._size = 0;
+        from._capacity = N;
+    }
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,107 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Stefan.Eilemann@epfl.ch
+ */
+
+#ifndef ZEQ_DETAIL_TYPETABLE_H
+#define ZEQ_DETAIL_TYPETABLE_H
+
+#include <zeq/types.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace zeq
+{
+namespace detail
+{
+
+/**
+ * A map from event types to values with lock-free lookups from any thread.
+ *
+ * A fixed hash table of append-only lists: entries are never removed, so
+ * references to values stay valid for the lifetime of the table. Only
+ * insertions take a lock. Values which are modified while other threads read
+ * them have to synchronize their members themselves, e.g., using atomics.
+ */
+template< typename V > class TypeTable
+{
+public:
+    TypeTable()
+    {
+        for( std::atomic< Node* >& bucket : _buckets )
+            bucket = nullptr;
+    }
+
+    ~TypeTable()
+    {
+        for( std::atomic< Node* >& bucket : _buckets )
+        {
+            const Node* node = bucket.load( std::memory_order_relaxed );
+            while( node )
+            {
+                const Node* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+    }
+
+    /** @return the value of the given type, or nullptr if not found */
+    V* find( const uint128_t& type ) const
+    {
+        Node* node = _getBucket( type ).load( std::memory_order_acquire );
+        for( ; node; node = node->next )
+        {
+            if( node->type == type )
+                return &node->value;
+        }
+        return nullptr;
+    }
+
+    /** @return the value of the given type, value-initialized if new */
+    V& get( const uint128_t& type )
+    {
+        V* value = find( type );
+        if( value )
+            return *value;
+
+        std::lock_guard< std::mutex > lock( _mutex );
+        std::atomic< Node* >& bucket = _getBucket( type );
+        Node* node = bucket.load( std::memory_order_relaxed );
+        for( ; node; node = node->next )
+        {
+            if( node->type == type ) // inserted while we waited for the lock
+                return node->value;
+        }
+
+        node = new Node( type, bucket.load( std::memory_order_relaxed ));
+        bucket.store( node, std::memory_order_release );
+        return node->value;
+    }
+
+private:
+    TypeTable( const TypeTable& ) = delete;
+    TypeTable& operator=( const TypeTable& ) = delete;
+
+    struct Node
+    {
+        Node( const uint128_t& type_, Node* next_ )
+            : type( type_ ), value(), next( next_ ) {}
+
+        const uint128_t type;
+        V value;
+        Node* const next;
+    };
+
+    static const size_t NUM_BUCKETS = 64;
+    mutable std::atomic< Node* > _buckets[ NUM_BUCKETS ];
+    std::mutex _mutex; // serializes insertions
+
+    std::atomic< Node* >& _getBucket( const uint128_t& type ) const
+        { return _buckets[ std::hash< uint128_t >()( type ) % NUM_BUCKETS ]; }
+};
+
+}
+}
+
+#endif
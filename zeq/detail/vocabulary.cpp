@@ -1,9 +1,11 @@
 
-/* Copyright (c) 2014-2015, Human Brain Project
+/* Copyright (c) 2014-2016, Human Brain Project
  *                          Daniel Nachbaur <daniel.nachbaur@epfl.ch>
  */
 
+#include "bufferPool.h"
 #include "event.h"
+#include "typeTable.h"
 
 #include "../eventDescriptor.h"
 #include "../vocabulary.h"
@@ -13,8 +15,12 @@
 #include <zeq/vocabulary_generated.h>
 
 #include <flatbuffers/idl.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <stdexcept>
+#include <vector>
 
 namespace zeq
 {
@@ -25,21 +31,103 @@ namespace detail
 
 namespace
 {
-typedef std::unordered_map< uint128_t, std::string > EventRegistry;
+/**
+ * A schema compiled once by registerEvent(). Never modified afterwards, so
+ * JSON generation uses it concurrently.
+ */
+struct Schema
+{
+    explicit Schema( const std::string& text_ )
+        : text( text_ )
+        , parser( compile( text, error ))
+    {}
+
+    static flatbuffers::Parser* compile( const std::string& text,
+                                         std::string& error )
+    {
+        flatbuffers::Parser* parser = new flatbuffers::Parser;
+        if( !parser->Parse( text.c_str( )))
+        {
+            error = parser->error_;
+            if( error.empty( ))
+                error = "Invalid JSON schema";
+        }
+        return parser;
+    }
+
+    const std::string text;
+    std::string error; // of the schema compilation
+    const std::unique_ptr< const flatbuffers::Parser > parser;
+};
+
+/**
+ * Registry of the compiled schemas with lock-free lookups.
+ *
+ * Registrations replace the schema of a type atomically. Replaced schemas are
+ * kept, since lookups on other threads may still use them; a type is
+ * registered again rarely, if at all.
+ */
+class EventRegistry
+{
+public:
+    const Schema* find( const uint128_t& type ) const
+    {
+        const std::atomic< const Schema* >* schema = _schemas.find( type );
+        return schema ? schema->load( std::memory_order_acquire ) : nullptr;
+    }
+
+    void add( const uint128_t& type, const std::string& text )
+    {
+        std::unique_ptr< const Schema > schema( new Schema( text ));
+
+        std::lock_guard< std::mutex > lock( _mutex );
+        std::atomic< const Schema* >& current = _schemas.get( type );
+        const Schema* replaced = current.exchange( schema.release( ));
+        if( replaced )
+            _replaced.emplace_back( replaced );
+    }
+
+private:
+    ::zeq::detail::TypeTable< std::atomic< const Schema* >> _schemas;
+    std::mutex _mutex; // serializes add()
+    std::vector< std::unique_ptr< const Schema >> _replaced;
+};
 
 EventRegistry& getRegistry()
 {
-    static EventRegistry _eventRegistry;
-    return _eventRegistry;
+    // Used by the static event registrations of the generated headers. Never
+    // destroyed, conversions may run during static destruction.
+    static EventRegistry* registry = new EventRegistry;
+    return *registry;
+}
+
+const Schema& getSchema( const uint128_t& type )
+{
+    const Schema* schema = getRegistry().find( type );
+    if( !schema )
+        ZEQTHROW( std::runtime_error( "JSON schema for event not registered" ));
+    if( !schema->error.empty( ))
+        ZEQTHROW( std::runtime_error( schema->error ));
+    return *schema;
 }
 
-const std::string& getSchema( const uint128_t& type )
+typedef std::unordered_map< const Schema*,
+                            std::unique_ptr< flatbuffers::Parser >> Parsers;
+
+/** @return the parser of this thread for JSON parsing with the schema */
+flatbuffers::Parser& getParser( Parsers& parsers, const Schema& schema )
 {
-    static const std::string nullString;
-    const EventRegistry& registry = getRegistry();
-    EventRegistry::const_iterator i = registry.find( type );
-    return ( i == registry.end( )) ? nullString : i->second;
+    std::unique_ptr< flatbuffers::Parser >& parser = parsers[ &schema ];
+    if( !parser )
+    {
+        std::string error;
+        parser.reset( Schema::compile( schema.text, error ));
+    }
+    return *parser;
 }
+
+// Parsing JSON modifies the parser, each thread compiles its own on first use
+thread_local Parsers _parsers;
 }
 
 Event serializeVocabulary( const EventDescriptors& vocabulary )
@@ -138,38 +226,48 @@ std::string deserializeEcho( const zeq::Event& event )
 
 zeq::Event serializeJSON( const uint128_t& type, const std::string& json )
 {
-    const std::string& schema = getSchema( type );
-    if( schema.empty( ))
-        ZEQTHROW( std::runtime_error( "JSON schema for event not registered" ));
-
+    const Schema& schema = getSchema( type );
     zeq::Event event( type );
-    flatbuffers::Parser& parser = event.getParser();
-    if( !parser.Parse( schema.c_str( )) || !parser.Parse( json.c_str( )))
-        ZEQTHROW( std::runtime_error( parser.error_ ));
+
+    flatbuffers::Parser& parser = getParser( _parsers, schema );
+    parser.builder_.Clear();
+    if( !parser.Parse( json.c_str( )))
+    {
+        const std::string error = parser.error_;
+        _parsers.erase( &schema ); // drop the state of the failed parse
+        ZEQTHROW( std::runtime_error( error ));
+    }
+
+    // the event owns a copy, the parser is reused for the next conversion
+    const flatbuffers::FlatBufferBuilder& fbb = parser.builder_;
+    event.setData( ::zeq::detail::BufferPool::getInstance().copy(
+                       fbb.GetBufferPointer(), fbb.GetSize( )),
+                   fbb.GetSize( ));
     return event;
 }
 
-std::string deserializeJSON( const zeq::Event& event )
+void deserializeJSON( const zeq::Event& event, std::string& json )
 {
-    const std::string& schema = getSchema( event.getType( ));
-    if( schema.empty( ))
-        ZEQTHROW( std::runtime_error( "JSON schema for event not registered" ));
-
-    flatbuffers::Parser parser;
-    if( !parser.Parse( schema.c_str( )))
-        ZEQTHROW( std::runtime_error( parser.error_ ));
+    const Schema& schema = getSchema( event.getType( ));
 
-    std::string json;
     flatbuffers::GeneratorOptions opts;
     opts.base64_byte_array = true;
     opts.strict_json = true;
-    GenerateText( parser, event.getData(), opts, &json );
+    json.clear(); // keeps the capacity
+    GenerateText( *schema.parser, event.getData(), opts, &json );
+}
+
+std::string deserializeJSON( const zeq::Event& event )
+{
+    std::string json;
+    deserializeJSON( event, json );
     return json;
 }
 
 void registerEvent( const uint128_t& type, const std::string& schema )
 {
-    getRegistry()[type] = schema;
+    // Compile the schema once, errors are reported on its use
+    getRegistry().add( type, schema );
 }
 
 }
@@ -29,6 +29,8 @@ std::string deserializeEcho( const zeq::Event& event );
 
 zeq::Event serializeJSON( const uint128_t& type, const std::string& json );
 
+void deserializeJSON( const zeq::Event& event, std::string& json );
+
 std::string deserializeJSON( const zeq::Event& event );
 
 void registerEvent( const uint128_t& type, const std::string& schema );
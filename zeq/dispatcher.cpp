@@ -0,0 +1,175 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#include "dispatcher.h"
+#include "log.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace zeq
+{
+namespace
+{
+// The dispatcher whose worker runs on this thread, if any
+thread_local const void* _currentDispatcher = nullptr;
+}
+
+class Dispatcher::Impl
+{
+public:
+    Impl( const size_t numThreads, const size_t queueSize )
+        : _capacity( queueSize )
+        , _size( 0 )
+        , _running( 0 )
+        , _stopping( false )
+    {
+        if( numThreads == 0 || queueSize == 0 )
+            ZEQTHROW( std::runtime_error(
+                          "Dispatcher needs at least one thread and task" ));
+
+        for( size_t i = 0; i < numThreads; ++i )
+            _threads.push_back( std::thread( [this] { _work(); }));
+    }
+
+    ~Impl()
+    {
+        {
+            std::unique_lock< std::mutex > lock( _mutex );
+            _stopping = true;
+        }
+        _ready.notify_all();
+        for( std::thread& thread : _threads )
+            thread.join();
+    }
+
+    void post( const uint128_t& key, const Task& task )
+    {
+        // Tasks posting to their own dispatcher would wait for themselves,
+        // their tasks are queued beyond the capacity instead.
+        const bool fromWorker = _currentDispatcher == this;
+
+        std::unique_lock< std::mutex > lock( _mutex );
+        while( _size >= _capacity && !fromWorker )
+            _notFull.wait( lock );
+
+        Strand& strand = _strands[ key ];
+        strand.tasks.push_back( task );
+        ++_size;
+        if( !strand.scheduled )
+        {
+            strand.scheduled = true;
+            _readyKeys.push_back( key );
+            _ready.notify_one();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock< std::mutex > lock( _mutex );
+        while( _size > 0 || _running > 0 )
+            _idle.wait( lock );
+    }
+
+private:
+    /** The queued tasks of one key, scheduled on at most one worker */
+    struct Strand
+    {
+        Strand() : scheduled( false ) {}
+
+        std::deque< Task > tasks;
+        bool scheduled;
+    };
+
+    const size_t _capacity;
+    size_t _size; // queued tasks of all strands
+    size_t _running; // tasks being run by workers
+    bool _stopping;
+
+    std::mutex _mutex;
+    std::condition_variable _ready; // a strand was scheduled or stopping
+    std::condition_variable _notFull;
+    std::condition_variable _idle;
+
+    std::unordered_map< uint128_t, Strand > _strands;
+    std::deque< uint128_t > _readyKeys; // scheduled strands with tasks
+    std::vector< std::thread > _threads;
+
+    void _work()
+    {
+        _currentDispatcher = this;
+        std::unique_lock< std::mutex > lock( _mutex );
+        while( true )
+        {
+            while( _readyKeys.empty() && !_stopping )
+                _ready.wait( lock );
+            if( _readyKeys.empty( )) // stopping and all tasks done
+                return;
+
+            // Run one task of the strand, then requeue it behind the others
+            // to not starve them on a busy event type.
+            const uint128_t key = _readyKeys.front();
+            _readyKeys.pop_front();
+            Strand& strand = _strands[ key ];
+            const Task task = strand.tasks.front();
+            strand.tasks.pop_front();
+            --_size;
+            ++_running;
+            _notFull.notify_one();
+
+            lock.unlock();
+            try
+            {
+                task();
+            }
+            catch( const std::exception& e )
+            {
+                ZEQWARN << "Event handler failed: " << e.what() << std::endl;
+            }
+            catch( ... )
+            {
+                ZEQWARN << "Event handler failed with unknown exception"
+                        << std::endl;
+            }
+            lock.lock();
+
+            --_running;
+            if( strand.tasks.empty( ))
+                strand.scheduled = false;
+            else
+            {
+                _readyKeys.push_back( key );
+                _ready.notify_one();
+            }
+            if( _size == 0 && _running == 0 )
+                _idle.notify_all();
+        }
+    }
+};
+
+Dispatcher::Dispatcher( const size_t numThreads, const size_t queueSize )
+    : _impl( new Impl( numThreads, queueSize ))
+{
+}
+
+Dispatcher::~Dispatcher()
+{
+}
+
+void Dispatcher::post( const uint128_t& key, const Task& task )
+{
+    _impl->post( key, task );
+}
+
+void Dispatcher::wait()
+{
+    _impl->wait();
+}
+
+}
@@ -0,0 +1,71 @@
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_DISPATCHER_H
+#define ZEQ_DISPATCHER_H
+
+#include <zeq/api.h>
+#include <zeq/types.h>
+
+#include <memory>
+
+namespace zeq
+{
+
+/**
+ * Runs event handlers on a pool of worker threads.
+ *
+ * Tasks posted with the same key, e.g., the event type, run in the order they
+ * were posted, one at a time. Tasks with different keys run concurrently. The
+ * number of queued tasks is bounded; post() blocks while the queue is full,
+ * which throttles a receiving Subscriber to the speed of its handlers.
+ *
+ * Thread safe.
+ *
+ * Example:
+ * @code
+ * zeq::Dispatcher dispatcher( 4 );
+ * subscriber.setDispatcher( &dispatcher );
+ * @endcode
+ */
+class Dispatcher
+{
+public:
+    /**
+     * Create a dispatcher and start its worker threads.
+     *
+     * @param numThreads the number of worker threads
+     * @param queueSize the maximum number of queued tasks
+     * @throw std::runtime_error if numThreads or queueSize is 0
+     */
+    ZEQ_API explicit Dispatcher( size_t numThreads, size_t queueSize = 1024 );
+
+    /** Run all queued tasks, then stop the worker threads. */
+    ZEQ_API ~Dispatcher();
+
+    /**
+     * Queue a task, blocking while the queue is full.
+     *
+     * Tasks of this dispatcher never block in post(), their tasks are queued
+     * beyond the maximum size instead.
+     *
+     * @param key tasks with the same key run sequentially in posting order
+     * @param task the task to run on a worker thread
+     */
+    ZEQ_API void post( const uint128_t& key, const Task& task );
+
+    /** Block until all queued tasks have run. */
+    ZEQ_API void wait();
+
+private:
+    class Impl;
+    std::unique_ptr< Impl > _impl;
+
+    Dispatcher( const Dispatcher& ) = delete;
+    Dispatcher& operator=( const Dispatcher& ) = delete;
+};
+
+}
+
+#endif
@@ -1,13 +1,77 @@
 
-/* Copyright (c) 2014-2015, Human Brain Project
+/* Copyright (c) 2014-2016, Human Brain Project
  *                          Daniel Nachbaur <daniel.nachbaur@epfl.ch>
  */
 
 #include "event.h"
 #include "detail/event.h"
 
+#include <cassert>
+#include <vector>
+
 namespace zeq
 {
+namespace
+{
+// Upper bound for idle events per thread, additional ones are freed
+const size_t MAX_IDLE_EVENTS = 64;
+
+class EventPool
+{
+public:
+    ~EventPool()
+    {
+        for( void* event : _idle )
+            ::operator delete( event );
+        _destroyed = true;
+    }
+
+    void* acquire()
+    {
+        if( _idle.empty( ))
+            return ::operator new( sizeof( detail::Event ));
+        void* event = _idle.back();
+        _idle.pop_back();
+        return event;
+    }
+
+    void release( void* event )
+    {
+        if( _idle.size() >= MAX_IDLE_EVENTS )
+            ::operator delete( event );
+        else
+            _idle.push_back( event );
+    }
+
+    /** @return true if the pool of this thread was destroyed on exit */
+    static bool isDestroyed() { return _destroyed; }
+
+private:
+    std::vector< void* > _idle;
+    static thread_local bool _destroyed;
+};
+
+thread_local bool EventPool::_destroyed = false;
+thread_local EventPool _eventPool;
+}
+
+void* detail::Event::operator new( const size_t bytes )
+{
+    assert( bytes == sizeof( detail::Event ));
+    (void)bytes;
+    return _eventPool.acquire();
+}
+
+void detail::Event::operator delete( void* ptr )
+{
+    if( !ptr )
+        return;
+    // may be destroyed by another thread, e.g., a dispatcher worker
+    if( EventPool::isDestroyed( ))
+        ::operator delete( ptr );
+    else
+        _eventPool.release( ptr );
+}
 
 Event::Event( const uint128_t& type )
     : _impl( new detail::Event( type ))
@@ -41,12 +105,17 @@ const void* Event::getData() const
 
 flatbuffers::FlatBufferBuilder& Event::getFBB()
 {
-    return _impl->parser.builder_;
+    return _impl->getFBB();
 }
 
 flatbuffers::Parser& Event::getParser()
 {
-    return _impl->parser;
+    return _impl->getParser();
+}
+
+ConstByteArray Event::getSharedData() const
+{
+    return _impl->getSharedData();
 }
 
 void Event::setData( const ConstByteArray& data, const size_t size )
@@ -54,4 +123,14 @@ void Event::setData( const ConstByteArray& data, const size_t size )
     _impl->setData( data, size );
 }
 
+void Event::setData( zmq_msg_t& message, const size_t offset )
+{
+    _impl->setData( message, offset );
+}
+
+void Event::detach()
+{
+    _impl->detach();
+}
+
 }
@@ -9,6 +9,8 @@
 #include <zeq/api.h>
 #include <zeq/types.h>
 
+struct zmq_msg_t;
+
 namespace zeq
 {
 namespace detail { class Event; }
@@ -52,9 +54,24 @@ public:
     /** @internal @return serialization specific implementation */
     ZEQ_API flatbuffers::Parser& getParser();
 
+    /** @internal @return the serialized data, sharing ownership with it */
+    ConstByteArray getSharedData() const;
+
     /** @internal Set a raw buffer as event data. */
     void setData( const ConstByteArray& data, const size_t size );
 
+    /**
+     * @internal Take ownership of a received message as event data, starting
+     * at the given offset in the message.
+     */
+    void setData( zmq_msg_t& message, size_t offset );
+
+    /**
+     * @internal Copy the data of a received message to a pooled buffer, for
+     * events which outlive their dispatch.
+     */
+    void detach();
+
 private:
     Event( const Event& ) = delete;
     Event& operator=( const Event& ) = delete;
@@ -0,0 +1,145 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#include "eventBatch.h"
+
+#include <cstring>
+#include <utility>
+
+namespace zeq
+{
+namespace
+{
+// FlatBuffers need their buffers aligned to the largest scalar
+const size_t ALIGNMENT = 8;
+
+size_t _align( const size_t size )
+{
+    return ( size + ALIGNMENT - 1 ) & ~( ALIGNMENT - 1 );
+}
+}
+
+EventBatch::EventBatch()
+{
+}
+
+EventBatch::~EventBatch()
+{
+}
+
+EventBatch::EventBatch( const EventBatch& rhs )
+    : _entries( rhs._entries )
+    , _data( rhs._data )
+{
+}
+
+EventBatch& EventBatch::operator=( const EventBatch& rhs )
+{
+    _entries = rhs._entries;
+    _data = rhs._data;
+    return *this;
+}
+
+EventBatch::EventBatch( EventBatch&& rhs )
+    : _entries( std::move( rhs._entries ))
+    , _data( std::move( rhs._data ))
+{
+    rhs.clear();
+}
+
+EventBatch& EventBatch::operator=( EventBatch&& rhs )
+{
+    if( this == &rhs )
+        return *this;
+
+    _entries = std::move( rhs._entries );
+    _data = std::move( rhs._data );
+    rhs.clear();
+    return *this;
+}
+
+size_t EventBatch::size() const
+{
+    return _entries.size();
+}
+
+bool EventBatch::empty() const
+{
+    return _entries.empty();
+}
+
+void EventBatch::clear()
+{
+    _entries.clear();
+    _data.clear();
+}
+
+void EventBatch::reserve( const size_t events, const size_t bytes )
+{
+    _entries.reserve( events );
+    _data.reserve( _align( bytes ) + events * ALIGNMENT );
+}
+
+const uint128_t& EventBatch::getType( const size_t index ) const
+{
+    return _entries[ index ].type;
+}
+
+const void* EventBatch::getData( const size_t index ) const
+{
+    const Entry& entry = _entries[ index ];
+    return entry.size == 0 ? nullptr : _data.data() + entry.offset;
+}
+
+size_t EventBatch::getSize( const size_t index ) const
+{
+    return _entries[ index ].size;
+}
+
+void EventBatch::add( const uint128_t& type, const void* data,
+                      const size_t size )
+{
+    const Entry entry = { type, _data.size(), size };
+    // resize() keeps the capacity, the buffer only grows to the largest batch
+    _data.resize( entry.offset + _align( size ));
+    if( size > 0 )
+        ::memcpy( _data.data() + entry.offset, data, size );
+    _entries.push_back( entry );
+}
+
+void EventBatch::add( const EventBatch& other )
+{
+    for( size_t i = 0; i < other.size(); ++i )
+        add( other.getType( i ), other.getData( i ), other.getSize( i ));
+}
+
+void EventBatch::take( EventBatch& other, const uint128_t& type )
+{
+    if( &other == this )
+        return;
+
+    size_t kept = 0;
+    size_t offset = 0;
+    for( Entry entry : other._entries )
+    {
+        uint8_t* data = other._data.data() + entry.offset;
+        if( entry.type == type )
+        {
+            add( entry.type, data, entry.size );
+            continue;
+        }
+
+        const size_t size = _align( entry.size );
+        if( entry.offset != offset )
+            ::memmove( other._data.data() + offset, data, size );
+        entry.offset = offset;
+        other._entries[ kept++ ] = entry;
+        offset += size;
+    }
+    other._entries.resize( kept );
+    other._data.resize( offset );
+}
+
+}
@@ -0,0 +1,117 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_EVENTBATCH_H
+#define ZEQ_EVENTBATCH_H
+
+#include <zeq/api.h>
+#include <zeq/types.h>
+
+#include <vector>
+
+namespace zeq
+{
+
+/**
+ * A reusable container of received events, filled by Subscriber::collect().
+ *
+ * The payloads of all events are stored back to back in one buffer, which
+ * keeps its capacity when the batch is cleared. A batch reused across collect()
+ * calls stops allocating once it has grown to the typical batch size. The
+ * payloads are aligned for FlatBuffers access.
+ *
+ * Example:
+ * @code
+ * zeq::EventBatch batch;
+ * subscriber.subscribe( EVENT_TOGGLEIDREQUEST );
+ * while( running )
+ * {
+ *     batch.clear();
+ *     subscriber.collect( batch, 100 );
+ *     for( size_t i = 0; i < batch.size(); ++i )
+ *         apply( batch.getData( i ), batch.getSize( i ));
+ * }
+ * @endcode
+ */
+class EventBatch
+{
+public:
+    ZEQ_API EventBatch();
+    ZEQ_API ~EventBatch();
+
+    ZEQ_API EventBatch( const EventBatch& rhs );
+    ZEQ_API EventBatch& operator=( const EventBatch& rhs );
+
+    /** Move the events and memory of the given batch, leaving it empty. */
+    ZEQ_API EventBatch( EventBatch&& rhs );
+    ZEQ_API EventBatch& operator=( EventBatch&& rhs );
+
+    /** @return the number of events in the batch */
+    ZEQ_API size_t size() const;
+
+    /** @return true if the batch holds no event */
+    ZEQ_API bool empty() const;
+
+    /** Remove all events, keeping the allocated memory for reuse. */
+    ZEQ_API void clear();
+
+    /**
+     * Preallocate memory for the given number of events and payload bytes.
+     *
+     * @param events the expected number of events
+     * @param bytes the expected total payload size
+     */
+    ZEQ_API void reserve( size_t events, size_t bytes );
+
+    /** @return the type of the event at the given index */
+    ZEQ_API const uint128_t& getType( size_t index ) const;
+
+    /**
+     * @return the serialized data of the event at the given index, valid
+     *         until the batch is modified
+     */
+    ZEQ_API const void* getData( size_t index ) const;
+
+    /** @return the size in bytes of the data of the event at the given index */
+    ZEQ_API size_t getSize( size_t index ) const;
+
+    /**
+     * Append a copy of the given event data.
+     *
+     * @param type the type of the event
+     * @param data the serialized event data
+     * @param size the size in bytes of the data
+     */
+    ZEQ_API void add( const uint128_t& type, const void* data, size_t size );
+
+    /** Append copies of all events of the given batch. */
+    ZEQ_API void add( const EventBatch& other );
+
+    /**
+     * Move the events of the given type from the given batch to this one.
+     *
+     * The remaining events of the other batch keep their order and are
+     * compacted in place, without allocating.
+     *
+     * @param other the batch to take the events from
+     * @param type the type of the events to take
+     */
+    ZEQ_API void take( EventBatch& other, const uint128_t& type );
+
+private:
+    struct Entry
+    {
+        uint128_t type;
+        size_t offset; // of the data in _data
+        size_t size;
+    };
+
+    std::vector< Entry > _entries;
+    std::vector< uint8_t > _data;
+};
+
+}
+
+#endif
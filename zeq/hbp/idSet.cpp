@@ -0,0 +1,210 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#include "idSet.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace zeq
+{
+namespace hbp
+{
+namespace data
+{
+namespace
+{
+const uint64_t NONE = std::numeric_limits< uint64_t >::max();
+
+uint64_t _end( const IDSet::Range& range )
+{
+    return uint64_t( range.start ) + range.count;
+}
+}
+
+IDSet::IDSet()
+    : _size( 0 )
+{}
+
+IDSet::IDSet( const std::vector< uint32_t >& ids )
+    : _size( 0 )
+{
+    if( std::is_sorted( ids.begin(), ids.end( )))
+    {
+        for( const uint32_t id : ids )
+            _append( id, uint64_t( id ) + 1 );
+        return;
+    }
+
+    std::vector< uint32_t > sorted( ids );
+    std::sort( sorted.begin(), sorted.end( ));
+    for( const uint32_t id : sorted )
+        _append( id, uint64_t( id ) + 1 );
+}
+
+IDSet::IDSet( const Ranges& ranges )
+    : _size( 0 )
+{
+    const auto byStart = []( const Range& a, const Range& b )
+                             { return a.start < b.start; };
+    if( std::is_sorted( ranges.begin(), ranges.end(), byStart ))
+    {
+        for( const Range& range : ranges )
+            _append( range.start, _end( range ));
+        return;
+    }
+
+    Ranges sorted( ranges );
+    std::sort( sorted.begin(), sorted.end(), byStart );
+    for( const Range& range : sorted )
+        _append( range.start, _end( range ));
+}
+
+void IDSet::add( const uint32_t start, const uint32_t count )
+{
+    if( count == 0 )
+        return;
+
+    if( _ranges.empty() || start >= _end( _ranges.back( )))
+    {
+        _append( start, uint64_t( start ) + count );
+        return;
+    }
+
+    IDSet ids;
+    ids._append( start, uint64_t( start ) + count );
+    *this = unite( *this, ids );
+}
+
+bool IDSet::contains( const uint32_t id ) const
+{
+    // first range starting after id, its predecessor may contain id
+    const auto i = std::upper_bound( _ranges.begin(), _ranges.end(), id,
+                                     []( const uint32_t value,
+                                         const Range& range )
+                                         { return value < range.start; } );
+    return i != _ranges.begin() && id < _end( *( i - 1 ));
+}
+
+void IDSet::clear()
+{
+    _ranges.clear();
+    _size = 0;
+}
+
+std::vector< uint32_t > IDSet::toIDs() const
+{
+    std::vector< uint32_t > ids;
+    toIDs( ids );
+    return ids;
+}
+
+void IDSet::toIDs( std::vector< uint32_t >& ids ) const
+{
+    ids.resize( _size );
+    size_t index = 0;
+    for( const Range& range : _ranges )
+        for( uint64_t id = range.start; id < _end( range ); ++id )
+            ids[ index++ ] = uint32_t( id );
+}
+
+bool IDSet::operator == ( const IDSet& rhs ) const
+{
+    if( _size != rhs._size || _ranges.size() != rhs._ranges.size( ))
+        return false;
+    for( size_t i = 0; i < _ranges.size(); ++i )
+        if( _ranges[i].start != rhs._ranges[i].start ||
+            _ranges[i].count != rhs._ranges[i].count )
+        {
+            return false;
+        }
+    return true;
+}
+
+void IDSet::_append( uint64_t start, const uint64_t end )
+{
+    // A range holds at most 2^32 - 1 IDs, so the ID 0xffffffff of a full
+    // range is kept in a second one.
+    const uint64_t maxCount = std::numeric_limits< uint32_t >::max();
+
+    // merge with an overlapping or adjacent last range
+    if( !_ranges.empty() && start <= _end( _ranges.back( )))
+    {
+        Range& last = _ranges.back();
+        const uint64_t lastEnd = _end( last );
+        if( end <= lastEnd )
+            return;
+
+        const uint64_t merged = std::min( end, last.start + maxCount );
+        _size += merged - lastEnd;
+        last.count = uint32_t( merged - last.start );
+        start = merged;
+    }
+
+    while( start < end )
+    {
+        const uint64_t next = std::min( end, start + maxCount );
+        const Range range = { uint32_t( start ), uint32_t( next - start ) };
+        _ranges.push_back( range );
+        _size += next - start;
+        start = next;
+    }
+}
+
+template< typename Op >
+IDSet IDSet::_combine( const IDSet& a, const IDSet& b, Op op )
+{
+    // Sweep over the boundaries of both range lists, emitting the segments
+    // for which op( in a, in b ) holds.
+    IDSet result;
+    const Ranges& lhs = a._ranges;
+    const Ranges& rhs = b._ranges;
+    size_t i = 0;
+    size_t j = 0;
+    uint64_t pos = std::min( i < lhs.size() ? lhs[i].start : NONE,
+                             j < rhs.size() ? rhs[j].start : NONE );
+    while( pos != NONE )
+    {
+        const bool inA = i < lhs.size() && lhs[i].start <= pos;
+        const bool inB = j < rhs.size() && rhs[j].start <= pos;
+        const uint64_t nextA = i >= lhs.size() ? NONE :
+                               inA ? _end( lhs[i] ) : lhs[i].start;
+        const uint64_t nextB = j >= rhs.size() ? NONE :
+                               inB ? _end( rhs[j] ) : rhs[j].start;
+        const uint64_t next = std::min( nextA, nextB );
+
+        if( op( inA, inB ))
+            result._append( pos, next );
+
+        pos = next;
+        if( i < lhs.size() && _end( lhs[i] ) <= pos )
+            ++i;
+        if( j < rhs.size() && _end( rhs[j] ) <= pos )
+            ++j;
+    }
+    return result;
+}
+
+IDSet unite( const IDSet& a, const IDSet& b )
+{
+    return IDSet::_combine( a, b, []( const bool inA, const bool inB )
+                                      { return inA || inB; } );
+}
+
+IDSet subtract( const IDSet& a, const IDSet& b )
+{
+    return IDSet::_combine( a, b, []( const bool inA, const bool inB )
+                                      { return inA && !inB; } );
+}
+
+IDSet toggle( const IDSet& a, const IDSet& b )
+{
+    return IDSet::_combine( a, b, []( const bool inA, const bool inB )
+                                      { return inA != inB; } );
+}
+
+}
+}
+}
@@ -0,0 +1,119 @@
+
+/* Copyright (c) 2016, Human Brain Project
+ *                     Daniel Nachbaur <daniel.nachbaur@epfl.ch>
+ */
+
+#ifndef ZEQ_HBP_IDSET_H
+#define ZEQ_HBP_IDSET_H
+
+#include <zeq/api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zeq
+{
+namespace hbp
+{
+namespace data
+{
+
+/**
+ * A set of neuron IDs, compressed as sorted runs of consecutive IDs.
+ *
+ * Selections of whole circuit regions consist of few long runs, which are
+ * much smaller to store and to send than the plain IDs. The set operations
+ * work directly on the runs, in time linear to their number.
+ */
+class IDSet
+{
+public:
+    /** A run of count consecutive IDs starting at start. */
+    struct Range
+    {
+        uint32_t start;
+        uint32_t count;
+    };
+    typedef std::vector< Range > Ranges;
+
+    /** Create an empty set. */
+    ZEQ_API IDSet();
+
+    /**
+     * Create a set of the given IDs.
+     * @param ids the IDs in any order, duplicates are ignored.
+     */
+    ZEQ_API explicit IDSet( const std::vector< uint32_t >& ids );
+
+    /**
+     * Create a set of the given runs of IDs.
+     * @param ranges the runs in any order, overlapping ones are merged.
+     */
+    ZEQ_API explicit IDSet( const Ranges& ranges );
+
+    /**
+     * Add consecutive IDs to the set.
+     *
+     * Appending IDs in ascending order takes constant time, other IDs are
+     * merged in linear time.
+     *
+     * @param start the first ID to add
+     * @param count the number of consecutive IDs to add
+     */
+    ZEQ_API void add( uint32_t start, uint32_t count = 1 );
+
+    /** @return true if the given ID is in the set */
+    ZEQ_API bool contains( uint32_t id ) const;
+
+    /** @return the number of IDs in the set */
+    size_t size() const { return _size; }
+
+    /** @return true if the set has no IDs */
+    bool empty() const { return _size == 0; }
+
+    /** Remove all IDs. */
+    ZEQ_API void clear();
+
+    /** @return the sorted, disjoint and non-adjacent runs of the set */
+    const Ranges& getRanges() const { return _ranges; }
+
+    /** @return the sorted IDs of the set */
+    ZEQ_API std::vector< uint32_t > toIDs() const;
+
+    /** Replace the given vector by the sorted IDs, reusing its memory. */
+    ZEQ_API void toIDs( std::vector< uint32_t >& ids ) const;
+
+    ZEQ_API bool operator == ( const IDSet& rhs ) const;
+    bool operator != ( const IDSet& rhs ) const { return !(*this == rhs); }
+
+private:
+    Ranges _ranges;
+    size_t _size;
+
+    void _append( uint64_t start, uint64_t end );
+    template< typename Op >
+    static IDSet _combine( const IDSet& a, const IDSet& b, Op op );
+
+    friend ZEQ_API IDSet unite( const IDSet& a, const IDSet& b );
+    friend ZEQ_API IDSet subtract( const IDSet& a, const IDSet& b );
+    friend ZEQ_API IDSet toggle( const IDSet& a, const IDSet& b );
+};
+
+/** @return the IDs which are in a or b */
+ZEQ_API IDSet unite( const IDSet& a, const IDSet& b );
+
+/** @return the IDs of a which are not in b */
+ZEQ_API IDSet subtract( const IDSet& a, const IDSet& b );
+
+/**
+ * @return the IDs which are either in a or in b, i.e., a with the IDs of b
+ *         toggled as by a ToggleIDRequest
+ */
+ZEQ_API IDSet toggle( const IDSet& a, const IDSet& b );
+
+}
+}
+}
+
+#endif
@@ -1,4 +1,4 @@
-/* Copyright (c) 2014-2015, Human Brain Project
+/* Copyright (c) 2014-2016, Human Brain Project
  *                          Daniel Nachbaur <daniel.nachbaur@epfl.ch>
  *                          Juan Hernando <jhernando@fi.upm.es@epfl.ch>
  *                          Grigori Chevtchenko <grigori.chevtchenko@epfl.ch>
@@ -13,9 +13,12 @@
 #include <zeq/hbp/selections_generated.h>
 #include <zeq/hbp/lookupTable1D_generated.h>
 #include <zeq/event.h>
+#include <zeq/log.h>
 #include <zeq/vocabulary.h>
 
 #include <cassert>
+#include <cstring>
+#include <stdexcept>
 
 namespace zeq
 {
@@ -36,22 +39,123 @@ void buildVectorOnlyBuffer(
     fbb.Finish( builder.Finish( ));
 }
 
+template< typename T, typename Builder >
+void buildVectorOnlyBuffer(
+    zeq::Event& event,
+    void (Builder::*adder)( flatbuffers::Offset< flatbuffers::Vector< T >>),
+    const size_t size, const std::function< void( T*, size_t ) >& write )
+{
+    flatbuffers::FlatBufferBuilder& fbb = event.getFBB();
+    T* data = nullptr;
+    const auto vector = fbb.CreateUninitializedVector( size, &data );
+    if( size > 0 )
+    {
+        write( data, size );
+#ifndef COMMON_LITTLEENDIAN
+        // FlatBuffers store scalars in little endian
+        for( size_t i = 0; i < size; ++i )
+            data[i] = flatbuffers::EndianScalar( data[i] );
+#endif
+    }
+    Builder builder( fbb );
+    (builder.*adder)( vector );
+    fbb.Finish( builder.Finish( ));
+}
+
 template< typename T >
-std::vector< T > deserializeVector( const flatbuffers::Vector< T >* in )
+void deserializeVector( const flatbuffers::Vector< T >* in,
+                        std::vector< T >& out )
 {
-    std::vector< T > out( in->Length( ));
-    for( flatbuffers::uoffset_t i = 0; i < in->Length(); ++i )
+    const size_t size = in ? in->Length() : 0;
+    out.resize( size );
+    if( size == 0 )
+        return;
+#ifdef COMMON_LITTLEENDIAN
+    // FlatBuffers store scalars in little endian, copy them at once
+    ::memcpy( out.data(), in->Data(), size * sizeof( T ));
+#else
+    for( flatbuffers::uoffset_t i = 0; i < size; ++i )
         out[i] = in->Get( i );
+#endif
+}
+
+template< typename T >
+std::vector< T > deserializeVector( const flatbuffers::Vector< T >* in )
+{
+    std::vector< T > out;
+    deserializeVector( in, out );
     return out;
 }
 
+template< typename T >
+data::Span< T > viewVector( const flatbuffers::Vector< T >* in )
+{
+    if( sizeof( T ) > 1 )
+    {
+#ifndef COMMON_LITTLEENDIAN
+        ZEQTHROW( std::runtime_error(
+                      "Views of event data need a little endian host" ));
+#endif
+    }
+    if( !in )
+        return data::Span< T >();
+    return data::Span< T >( reinterpret_cast< const T* >( in->Data( )),
+                            in->Length( ));
+}
+
 template< typename T, typename U >
-std::vector< T > deserializeVector(
+const flatbuffers::Vector< T >* getVector(
     const zeq::Event& event,
     const flatbuffers::Vector< T >* (U::*getter)( ) const )
 {
     auto data = flatbuffers::GetRoot< U >( event.getData( ));
-    return deserializeVector(( data->*getter )( ));
+    return ( data->*getter )( );
+}
+
+template< typename T, typename U >
+std::vector< T > deserializeVector(
+    const zeq::Event& event,
+    const flatbuffers::Vector< T >* (U::*getter)( ) const )
+{
+    return deserializeVector( getVector( event, getter ));
+}
+
+typedef flatbuffers::Vector< uint32_t > IDVector;
+
+/** Serialize the runs of the set as start, count pairs. */
+flatbuffers::Offset< IDVector > createRanges(
+    flatbuffers::FlatBufferBuilder& fbb, const data::IDSet& ids )
+{
+    const data::IDSet::Ranges& ranges = ids.getRanges();
+    const size_t size = ranges.size() * 2;
+    fbb.StartVector( size, sizeof( uint32_t ));
+    for( auto i = ranges.rbegin(); i != ranges.rend(); ++i ) // back to front
+    {
+        fbb.PushElement( i->count );
+        fbb.PushElement( i->start );
+    }
+    return flatbuffers::Offset< IDVector >( fbb.EndVector( size ));
+}
+
+/**
+ * Deserialize the start, count pairs of createRanges(). Ranges from other
+ * writers may be unsorted or overlap, they are sorted and merged once.
+ */
+void deserializeRanges( const IDVector* ranges, data::IDSet& out )
+{
+    out.clear();
+    if( !ranges )
+        return;
+
+    data::IDSet::Ranges pairs;
+    pairs.reserve( ranges->Length() / 2 );
+    for( flatbuffers::uoffset_t i = 0; i + 1 < ranges->Length(); i += 2 )
+    {
+        const data::IDSet::Range range = { ranges->Get( i ),
+                                           ranges->Get( i + 1 ) };
+        pairs.push_back( range );
+    }
+    out = data::IDSet( pairs );
 }
 
 #define BUILD_VECTOR_ONLY_BUFFER( event, type, vector ) \
@@ -72,6 +176,17 @@ std::vector< float > deserializeCamera( const Event& event )
     return deserializeVector( data->matrix( ));
 }
 
+void deserializeCamera( const Event& event, std::vector< float >& matrix )
+{
+    deserializeVector( getVector( event, &Camera::matrix ), matrix );
+    assert( matrix.size() == 16 );
+}
+
+data::Span< float > viewCamera( const Event& event )
+{
+    return viewVector( getVector( event, &Camera::matrix ));
+}
+
 ZEQ_API Event serializeFrame( const data::Frame& frame )
 {
     ::zeq::Event event( ::zeq::hbp::EVENT_FRAME );
@@ -110,6 +225,15 @@ ZEQ_API data::Frame deserializeFrame( const Event& event )
     return event;
 }
 
+::zeq::Event serializeImageJPEG( const uint32_t sizeInBytes,
+                                 const ByteWriter& write )
+{
+    ::zeq::Event event( EVENT_IMAGEJPEG );
+    buildVectorOnlyBuffer( event, &ImageJPEGBuilder::add_data, sizeInBytes,
+                           write );
+    return event;
+}
+
 data::ImageJPEG deserializeImageJPEG( const ::zeq::Event& event )
 {
     auto data = GetImageJPEG( event.getData( ) );
@@ -123,11 +247,47 @@ Event serializeSelectedIDs( const uint32_ts& ids )
     return event;
 }
 
+Event serializeSelectedIDs( const size_t size, const IDWriter& write )
+{
+    zeq::Event event( EVENT_SELECTEDIDS );
+    buildVectorOnlyBuffer( event, &SelectedIDsBuilder::add_ids, size, write );
+    return event;
+}
+
+Event serializeSelectedIDRanges( const data::IDSet& ids )
+{
+    zeq::Event event( EVENT_SELECTEDIDRANGES );
+    flatbuffers::FlatBufferBuilder& fbb = event.getFBB();
+    const auto ranges = createRanges( fbb, ids );
+    SelectedIDRangesBuilder builder( fbb );
+    builder.add_ranges( ranges );
+    fbb.Finish( builder.Finish( ));
+    return event;
+}
+
 uints deserializeSelectedIDs( const Event& event )
 {
     return deserializeVector( event, &SelectedIDs::ids );
 }
 
+void deserializeSelectedIDs( const Event& event, uint32_ts& ids )
+{
+    deserializeVector( getVector( event, &SelectedIDs::ids ), ids );
+}
+
+void deserializeSelectedIDs( const Event& event, data::IDSet& ids )
+{
+    if( event.getType() == EVENT_SELECTEDIDRANGES )
+        deserializeRanges( getVector( event, &SelectedIDRanges::ranges ), ids );
+    else
+        ids = data::IDSet( deserializeSelectedIDs( event ));
+}
+
+data::Span< uint32_t > viewSelectedIDs( const Event& event )
+{
+    return viewVector( getVector( event, &SelectedIDs::ids ));
+}
+
 zeq::Event serializeToggleIDRequest( const uint32_ts& ids )
 {
     zeq::Event event( EVENT_TOGGLEIDREQUEST );
@@ -135,11 +295,49 @@ zeq::Event serializeToggleIDRequest( const uint32_ts& ids )
     return event;
 }
 
+zeq::Event serializeToggleIDRequest( const size_t size, const IDWriter& write )
+{
+    zeq::Event event( EVENT_TOGGLEIDREQUEST );
+    buildVectorOnlyBuffer( event, &ToggleIDRequestBuilder::add_ids, size,
+                           write );
+    return event;
+}
+
+zeq::Event serializeToggleIDRangeRequest( const data::IDSet& ids )
+{
+    zeq::Event event( EVENT_TOGGLEIDRANGEREQUEST );
+    flatbuffers::FlatBufferBuilder& fbb = event.getFBB();
+    const auto ranges = createRanges( fbb, ids );
+    ToggleIDRangeRequestBuilder builder( fbb );
+    builder.add_ranges( ranges );
+    fbb.Finish( builder.Finish( ));
+    return event;
+}
+
 uints deserializeToggleIDRequest( const zeq::Event& event )
 {
     return deserializeVector( event, &ToggleIDRequest::ids );
 }
 
+void deserializeToggleIDRequest( const Event& event, uint32_ts& ids )
+{
+    deserializeVector( getVector( event, &ToggleIDRequest::ids ), ids );
+}
+
+void deserializeToggleIDRequest( const Event& event, data::IDSet& ids )
+{
+    if( event.getType() == EVENT_TOGGLEIDRANGEREQUEST )
+        deserializeRanges( getVector( event, &ToggleIDRangeRequest::ranges ),
+                           ids );
+    else
+        ids = data::IDSet( deserializeToggleIDRequest( event ));
+}
+
+data::Span< uint32_t > viewToggleIDRequest( const Event& event )
+{
+    return viewVector( getVector( event, &ToggleIDRequest::ids ));
+}
+
 zeq::Event serializeLookupTable1D( const std::vector< uint8_t >& lut )
 {
     assert( lut.size() == 1024 );
@@ -148,6 +346,13 @@ zeq::Event serializeLookupTable1D( const std::vector< uint8_t >& lut )
     return event;
 }
 
+zeq::Event serializeLookupTable1D( const ByteWriter& write )
+{
+    zeq::Event event( EVENT_LOOKUPTABLE1D );
+    buildVectorOnlyBuffer( event, &LookupTable1DBuilder::add_lut, 1024, write );
+    return event;
+}
+
 std::vector< uint8_t > deserializeLookupTable1D( const Event& event )
 {
     auto data = GetLookupTable1D( event.getData( ));
@@ -155,6 +360,17 @@ std::vector< uint8_t > deserializeLookupTable1D( const Event& event )
     return deserializeVector( data->lut( ));
 }
 
+void deserializeLookupTable1D( const Event& event, std::vector< uint8_t >& lut )
+{
+    deserializeVector( getVector( event, &LookupTable1D::lut ), lut );
+    assert( lut.size() == 1024 );
+}
+
+data::Span< uint8_t > viewLookupTable1D( const Event& event )
+{
+    return viewVector( getVector( event, &LookupTable1D::lut ));
+}
+
 Event serializeCellSetBinaryOp( const data::CellSetBinaryOp& cellSetBinaryOp )
 {
   zeq::Event event( EVENT_CELLSETBINARYOP );
@@ -181,6 +397,24 @@ Event serializeCellSetBinaryOp( const uint32_ts& first, const uint32_ts& second,
         data::CellSetBinaryOp( first, second, type ));
 }
 
+Event serializeCellSetBinaryOpRanges( const data::IDSet& first,
+                                      const data::IDSet& second,
+                                      const CellSetBinaryOpType type )
+{
+    zeq::Event event( EVENT_CELLSETBINARYOPRANGES );
+    flatbuffers::FlatBufferBuilder& fbb = event.getFBB();
+
+    const auto firstRanges = createRanges( fbb, first );
+    const auto secondRanges = createRanges( fbb, second );
+
+    CellSetBinaryOpRangesBuilder builder( fbb );
+    builder.add_first( firstRanges );
+    builder.add_second( secondRanges );
+    builder.add_operation( type );
+    fbb.Finish( builder.Finish( ));
+    return event;
+}
+
 data::CellSetBinaryOp
 deserializeCellSetBinaryOp( const Event& event )
 {
@@ -193,5 +427,44 @@ deserializeCellSetBinaryOp( const Event& event )
                                 CellSetBinaryOpType(data->operation( )));
 }
 
+void deserializeCellSetBinaryOp( const Event& event,
+                                 data::CellSetBinaryOp& cellSetBinaryOp )
+{
+    auto data = GetCellSetBinaryOp( event.getData( ));
+    deserializeVector( data->first(), cellSetBinaryOp.first );
+    deserializeVector( data->second(), cellSetBinaryOp.second );
+    cellSetBinaryOp.operation = CellSetBinaryOpType( data->operation( ));
+}
+
+void deserializeCellSetBinaryOp( const Event& event, data::IDSet& first,
+                                 data::IDSet& second,
+                                 CellSetBinaryOpType& operation )
+{
+    if( event.getType() == EVENT_CELLSETBINARYOPRANGES )
+    {
+        auto data = flatbuffers::GetRoot< CellSetBinaryOpRanges >(
+                        event.getData( ));
+        deserializeRanges( data->first(), first );
+        deserializeRanges( data->second(), second );
+        operation = CellSetBinaryOpType( data->operation( ));
+        return;
+    }
+
+    auto data = GetCellSetBinaryOp( event.getData( ));
+    first = data::IDSet( deserializeVector( data->first( )));
+    second = data::IDSet( deserializeVector( data->second( )));
+    operation = CellSetBinaryOpType( data->operation( ));
+}
+
+data::CellSetBinaryOpView viewCellSetBinaryOp( const Event& event )
+{
+    auto data = GetCellSetBinaryOp( event.getData( ));
+    data::CellSetBinaryOpView view;
+    view.first = viewVector( data->first( ));
+    view.second = viewVector( data->second( ));
+    view.operation = CellSetBinaryOpType( data->operation( ));
+    return view;
+}
+
 }
 }
@@ -1,5 +1,5 @@
 
-/* Copyright (c) 2014-2015, Human Brain Project
+/* Copyright (c) 2014-2016, Human Brain Project
  *                          Daniel Nachbaur <daniel.nachbaur@epfl.ch>
  *                          Juan Hernando <jhernando@fi.upm.es>
  *                          Grigori Chevtchenko <grigori.chevtchenko@epfl.ch>
@@ -12,6 +12,7 @@
 #include <zeq/api.h>
 
 #include <zeq/hbp/enums.h>
+#include <zeq/hbp/idSet.h>
 
 #include <zeq/hbp/camera_zeq_generated.h>
 #include <zeq/hbp/cellSetBinaryOp_zeq_generated.h>
@@ -27,9 +28,40 @@ namespace hbp
 
 typedef std::vector< uint32_t > uint32_ts;
 
+/**
+ * Writes the given number of elements into the uninitialized array of an
+ * event, which is serialized in place without intermediate copies.
+ */
+typedef std::function< void( uint32_t* ids, size_t size ) > IDWriter;
+typedef std::function< void( uint8_t* data, size_t size ) > ByteWriter;
+
 namespace data
 {
 
+/**
+ * A read-only view of an array in the data of an event.
+ *
+ * Like ImageJPEG, the view does not copy the data and is only valid as long as
+ * the zeq Event stays alive.
+ */
+template< typename T > struct Span
+{
+    Span() : _data( nullptr ), _size( 0 ) {}
+    Span( const T* data, const size_t size ) : _data( data ), _size( size ) {}
+
+    const T* data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    const T* begin() const { return _data; }
+    const T* end() const { return _data + _size; }
+    const T& operator[]( const size_t i ) const { return _data[i]; }
+
+private:
+    const T* _data;
+    size_t _size;
+};
+
 /** Rendering frame information. */
 struct Frame
 {
@@ -101,6 +133,14 @@ public:
     CellSetBinaryOpType operation;
 };
 
+/** A view of a CellSetBinaryOp in the data of an event, see Span. */
+struct CellSetBinaryOpView
+{
+    Span< uint32_t > first;
+    Span< uint32_t > second;
+    CellSetBinaryOpType operation;
+};
+
 }
 
 /**
@@ -126,6 +166,22 @@ ZEQ_API Event serializeCamera( const std::vector< float >& matrix );
  */
 ZEQ_API std::vector< float > deserializeCamera( const Event& event );
 
+/**
+ * Deserialize the given camera event into the given 4x4 matrix, reusing its
+ * memory.
+ * @param camera the camera event generated by serializeCamera().
+ * @param matrix the 4x4 camera matrix in OpenGL data layout.
+ */
+ZEQ_API void deserializeCamera( const Event& event,
+                                std::vector< float >& matrix );
+
+/**
+ * @return a view of the 4x4 camera matrix in the given camera event, see
+ *         deserializeCamera().
+ * @throw std::runtime_error on big endian hosts.
+ */
+ZEQ_API data::Span< float > viewCamera( const Event& event );
+
 /**
  * Serialize the given frame specification
  *
@@ -143,7 +199,7 @@ ZEQ_API data::Frame deserializeFrame( const Event& event );
 
 /**
  * Serialize the given neuron selection into an Event of type
- * EVENT_SELECTED_IDS.
+ * EVENT_SELECTEDIDS.
  * @param selection vector of neuron GIDs (uint).
  * @return the serialized event.
  */
@@ -159,7 +215,51 @@ ZEQ_API
 std::vector< unsigned int > deserializeSelectedIDs( const Event& event );
 
 /**
- * Serialize the given selection into an Event of type EVENT_TOGGLE_ID_REQUEST.
+ * Deserialize the given neuron selection event into the given vector,
+ * reusing its memory.
+ * @param event a selection event generated by serializeSelection().
+ * @param ids the vector of neuron GIDs (uint).
+ */
+ZEQ_API void deserializeSelectedIDs( const Event& event, uint32_ts& ids );
+
+/**
+ * Serialize the given neuron selection as runs of consecutive GIDs into an
+ * Event of type EVENT_SELECTEDIDRANGES.
+ *
+ * The event is much smaller for contiguous selections. It has its own type so
+ * that subscribers to EVENT_SELECTEDIDS never receive it; only the IDSet
+ * overload of deserializeSelectedIDs() reads it.
+ * @param ids the set of neuron GIDs.
+ * @return the serialized event.
+ */
+ZEQ_API Event serializeSelectedIDRanges( const data::IDSet& ids );
+
+/**
+ * Serialize a neuron selection written in place by the given function into an
+ * Event of type EVENT_SELECTEDIDS.
+ * @param size the number of neuron GIDs.
+ * @param write the function writing the GIDs into the event.
+ * @return the serialized event.
+ */
+ZEQ_API Event serializeSelectedIDs( size_t size, const IDWriter& write );
+
+/**
+ * Deserialize the given neuron selection event into the given set.
+ * @param event an event generated by serializeSelectedIDs() or
+ *        serializeSelectedIDRanges().
+ * @param ids the set of neuron GIDs.
+ */
+ZEQ_API void deserializeSelectedIDs( const Event& event, data::IDSet& ids );
+
+/**
+ * @return a view of the neuron GIDs in the given selection event, without
+ *         copying them.
+ * @throw std::runtime_error on big endian hosts.
+ */
+ZEQ_API data::Span< uint32_t > viewSelectedIDs( const Event& event );
+
+/**
+ * Serialize the given selection into an Event of type EVENT_TOGGLEIDREQUEST.
  * @param ids vector of neuron GIDs (uint).
  * @return the serialized event.
  */
@@ -174,6 +274,47 @@ Event serializeToggleIDRequest( const uint32_ts& ids );
 ZEQ_API
 std::vector< unsigned int > deserializeToggleIDRequest( const Event& event );
 
+/**
+ * Deserialize an toggle selection request event into the given vector,
+ * reusing its memory.
+ * @param event an event generated by serializeToggleIDRequest().
+ * @param ids the vector of neuron GIDs (uint).
+ */
+ZEQ_API void deserializeToggleIDRequest( const Event& event, uint32_ts& ids );
+
+/**
+ * Serialize the given selection as runs of consecutive GIDs into an Event of
+ * type EVENT_TOGGLEIDRANGEREQUEST.
+ * @param ids the set of neuron GIDs.
+ * @return the serialized event.
+ */
+ZEQ_API Event serializeToggleIDRangeRequest( const data::IDSet& ids );
+
+/**
+ * Serialize a selection written in place by the given function into an Event
+ * of type EVENT_TOGGLEIDREQUEST.
+ * @param size the number of neuron GIDs.
+ * @param write the function writing the GIDs into the event.
+ * @return the serialized event.
+ */
+ZEQ_API Event serializeToggleIDRequest( size_t size, const IDWriter& write );
+
+/**
+ * Deserialize an toggle selection request event into the given set.
+ * @param event an event generated by serializeToggleIDRequest() or
+ *        serializeToggleIDRangeRequest().
+ * @param ids the set of neuron GIDs.
+ */
+ZEQ_API void deserializeToggleIDRequest( const Event& event,
+                                         data::IDSet& ids );
+
+/**
+ * @return a view of the neuron GIDs in the given toggle selection request
+ *         event, without copying them.
+ * @throw std::runtime_error on big endian hosts.
+ */
+ZEQ_API data::Span< uint32_t > viewToggleIDRequest( const Event& event );
+
 /**
  * Serialize the given lookup table into an Event of type EVENT_LOOKUPTABLE1D.
  * The lookup table consists of 4 times 256 bytes, interleaved in r,g,b,a
@@ -184,6 +325,14 @@ std::vector< unsigned int > deserializeToggleIDRequest( const Event& event );
  */
 ZEQ_API Event serializeLookupTable1D( const std::vector< uint8_t >& lut );
 
+/**
+ * Serialize a lookup table written in place by the given function into an
+ * Event of type EVENT_LOOKUPTABLE1D.
+ * @param write the function writing the 1024 byte lookup table.
+ * @return the serialized event.
+ */
+ZEQ_API Event serializeLookupTable1D( const ByteWriter& write );
+
 /**
  * Deserialize the given 1D lookup table.
  * @param camera the camera event generated by serializeCamera().
@@ -192,6 +341,18 @@ ZEQ_API Event serializeLookupTable1D( const std::vector< uint8_t >& lut );
  */
 ZEQ_API std::vector< uint8_t > deserializeLookupTable1D( const Event& event );
 
+/**
+ * Deserialize the given 1D lookup table into the given vector, reusing its
+ * memory.
+ * @param event the event generated by serializeLookupTable1D().
+ * @param lut the 1024 byte lookup table.
+ */
+ZEQ_API void deserializeLookupTable1D( const Event& event,
+                                       std::vector< uint8_t >& lut );
+
+/** @return a view of the 1024 byte lookup table in the given event. */
+ZEQ_API data::Span< uint8_t > viewLookupTable1D( const Event& event );
+
 /**
  * Serialize the given JPEG image into an Event of type EVENT_IMAGEJPEG.
  * @param image the JPEG image.
@@ -199,6 +360,16 @@ ZEQ_API std::vector< uint8_t > deserializeLookupTable1D( const Event& event );
  */
 ZEQ_API Event serializeImageJPEG( const data::ImageJPEG& image );
 
+/**
+ * Serialize a JPEG image written in place by the given function into an Event
+ * of type EVENT_IMAGEJPEG, e.g., by a JPEG encoder.
+ * @param sizeInBytes the size of the JPEG image.
+ * @param write the function writing the JPEG image into the event.
+ * @return the serialized event.
+ */
+ZEQ_API Event serializeImageJPEG( uint32_t sizeInBytes,
+                                  const ByteWriter& write );
+
 /**
  * Deserialize the given EVENT_IMAGEJPEG event into an JPEG image.
  * @param event the zeq EVENT_IMAGEJPEG.
@@ -222,6 +393,18 @@ ZEQ_API
 Event serializeCellSetBinaryOp( const uint32_ts& first, const uint32_ts& second,
                                 CellSetBinaryOpType type );
 
+/**
+ * Serialize the given sets as runs of consecutive GIDs into an Event of type
+ * EVENT_CELLSETBINARYOPRANGES.
+ * @param first the first set of neuron GIDs.
+ * @param second the second set of neuron GIDs.
+ * @param type the operation to apply on both sets.
+ * @return the serialized event.
+ */
+ZEQ_API Event serializeCellSetBinaryOpRanges( const data::IDSet& first,
+                                              const data::IDSet& second,
+                                              CellSetBinaryOpType type );
+
 /**
  * Deserialize the given EVENT_CELLSETBINARYOP event into a CellSetBinaryOp
  * consisting of a couple of std::vector of unsigned int and the operation type.
@@ -230,6 +413,36 @@ Event serializeCellSetBinaryOp( const uint32_ts& first, const uint32_ts& second,
  */
 ZEQ_API data::CellSetBinaryOp deserializeCellSetBinaryOp( const Event& event );
 
+/**
+ * Deserialize the given EVENT_CELLSETBINARYOP event into the given
+ * CellSetBinaryOp, reusing the memory of its vectors.
+ * @param event the event product of serializeCellSetBinaryOp.
+ * @param cellSetBinaryOp the deserialized CellSetBinaryOp.
+ */
+ZEQ_API void deserializeCellSetBinaryOp( const Event& event,
+                                      data::CellSetBinaryOp& cellSetBinaryOp );
+
+/**
+ * Deserialize the given EVENT_CELLSETBINARYOP or EVENT_CELLSETBINARYOPRANGES
+ * event into two sets and the operation type.
+ * @param event the event product of serializeCellSetBinaryOp or
+ *        serializeCellSetBinaryOpRanges.
+ * @param first the first set of neuron GIDs.
+ * @param second the second set of neuron GIDs.
+ * @param operation the operation to apply on both sets.
+ */
+ZEQ_API void deserializeCellSetBinaryOp( const Event& event,
+                                         data::IDSet& first,
+                                         data::IDSet& second,
+                                         CellSetBinaryOpType& operation );
+
+/**
+ * @return a view of the vectors and the operation type of the given
+ *         EVENT_CELLSETBINARYOP event, without copying them.
+ * @throw std::runtime_error on big endian hosts.
+ */
+ZEQ_API data::CellSetBinaryOpView viewCellSetBinaryOp( const Event& event );
+
 }
 }
 #endif
@@ -265,7 +265,9 @@ Server::Server()
 {}
 
 Server::~Server()
-{}
+{
+    leaveGroup();
+}
 
 
 std::unique_ptr< Server > Server::parse( const int argc, char* argv[] )
@@ -317,9 +319,10 @@ void Server::addSockets( std::vector< detail::Socket >& entries )
     _impl->addSockets( entries );
 }
 
-void Server::process( detail::Socket& socket )
+size_t Server::process( detail::Socket& socket )
 {
     _impl->process( socket );
+    return 1;
 }
 
 }
@@ -126,7 +126,7 @@ private:
 
     // Receiver API
     void addSockets( std::vector< detail::Socket >& entries ) final;
-    void process( detail::Socket& socket ) final;
+    size_t process( detail::Socket& socket ) final;
     void addConnection( const std::string& ) final
     {
         throw std::runtime_error( "Add connection to HTTP server unsupported" );
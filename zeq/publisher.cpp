@@ -7,10 +7,14 @@
 #include "publisher.h"
 #include "event.h"
 #include "log.h"
+#include "detail/boundedQueue.h"
 #include "detail/broker.h"
+#include "detail/bufferPool.h"
 #include "detail/byteswap.h"
+#include "detail/compression.h"
 #include "detail/constants.h"
 #include "detail/sender.h"
+#include "detail/typeTable.h"
 
 #include <servus/serializable.h>
 #include <servus/servus.h>
@@ -19,14 +23,26 @@
 #  include <mach-o/dyld.h>
 #endif
 
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 namespace zeq
 {
 
 namespace
 {
+// Below this size copying the payload is cheaper than the bookkeeping needed
+// to hand the buffer over to ZeroMQ.
+const size_t ZERO_COPY_THRESHOLD = 4096;
+
 std::string _getApplicationName()
 {
     // http://stackoverflow.com/questions/933850
@@ -68,9 +84,25 @@ class Publisher::Impl : public detail::Sender
 {
 public:
     Impl( servus::URI uri_, const uint32_t announceMode )
-        : detail::Sender( uri_, 0, ZMQ_PUB )
+        : detail::Sender( uri_, 0, ZMQ_XPUB )
         , _service( PUBLISHER_SERVICE )
         , _session( getDefaultSession( ))
+        , _zeroCopy( false )
+        , _format( FORMAT_TWO_FRAMES )
+        , _policy( OVERFLOW_BLOCK )
+        , _maxQueued( 0 )
+        , _wakeup( 0 )
+        , _notify( 0 )
+        , _running( false )
+        , _producerWaiting( 0 )
+        , _consumerWaiting( false )
+        , _sent( 0 )
+        , _dropped( 0 )
+        , _compressedEvents( 0 )
+        , _uncompressedBytes( 0 )
+        , _compressedBytes( 0 )
+        , _compressionTime( 0 )
+        , _anyPrefix( false )
     {
         uri_.setScheme( "" );
         const std::string& zmqURI = buildZmqURI( uri_ );
@@ -88,9 +120,25 @@ public:
     }
 
     Impl( const URI& uri_, const std::string& session )
-        : detail::Sender( uri_, 0, ZMQ_PUB )
+        : detail::Sender( uri_, 0, ZMQ_XPUB )
         , _service( PUBLISHER_SERVICE )
         , _session( session == DEFAULT_SESSION ? getDefaultSession() : session )
+        , _zeroCopy( false )
+        , _format( FORMAT_TWO_FRAMES )
+        , _policy( OVERFLOW_BLOCK )
+        , _maxQueued( 0 )
+        , _wakeup( 0 )
+        , _notify( 0 )
+        , _running( false )
+        , _producerWaiting( 0 )
+        , _consumerWaiting( false )
+        , _sent( 0 )
+        , _dropped( 0 )
+        , _compressedEvents( 0 )
+        , _uncompressedBytes( 0 )
+        , _compressedBytes( 0 )
+        , _compressionTime( 0 )
+        , _anyPrefix( false )
     {
         if( session.empty( ))
             ZEQTHROW( std::runtime_error(
@@ -112,62 +160,655 @@ public:
             _initService();
     }
 
-    ~Impl() {}
+    ~Impl()
+    {
+        // the send thread drains the queue before it exits
+        if( _thread.joinable( ))
+            _stopThread();
+
+        // before the context is destroyed by ~Sender()
+        if( _notify )
+            zmq_close( _notify );
+        if( _wakeup )
+            zmq_close( _wakeup );
+    }
 
     bool publish( const zeq::Event& event )
     {
-#ifdef COMMON_LITTLEENDIAN
         const uint128_t& type = event.getType();
-#else
-        uint128_t type = event.getType();
-        detail::byteswap( type ); // convert to little endian wire protocol
+        const size_t size = event.getSize();
+
+        // the send thread caches, filters and compresses queued events
+        if( _queue )
+        {
+            if( !_isCached( type ) && !hasSubscribers( type ))
+                return true;
+            return _enqueue( type, event.getSharedData(), size );
+        }
+
+        const SocketLock lock( *this );
+        if( _isCached( type ))
+            _cache( Item( type, event.getSharedData(), size ));
+
+        if( !_hasSubscribers( type ))
+            return true;
+
+        if( _useZeroCopy( type, size ))
+        {
+            return _sendHeader( type, true ) &&
+                   _sendData( event.getSharedData(), size );
+        }
+        return _send( type, event.getData(), size );
+    }
+
+    bool publish( const servus::Serializable& serializable )
+    {
+        const uint128_t& type = serializable.getTypeIdentifier();
+        const bool cached = _isCached( type );
+        if( !cached && !hasSubscribers( type ))
+            return true;
+
+        const servus::Serializable::Data& data = serializable.toBinary();
+        const size_t size = data.ptr ? data.size : 0;
+
+        // The serializable may reuse its buffer once this returns, data sent
+        // or cached later is copied
+        if( _queue )
+            return _enqueue( type, _copy( data ), size );
+
+        const SocketLock lock( *this );
+        if( cached )
+        {
+            const ConstByteArray copy = _copy( data );
+            _cache( Item( type, copy, size ));
+            if( !_hasSubscribers( type ))
+                return true;
+
+            if( _useZeroCopy( type, size ))
+                return _sendHeader( type, true ) && _sendData( copy, size );
+        }
+        return _send( type, data.ptr.get(), size );
+    }
+
+    bool publish( const uint128_t& type, const EventProducer& producer )
+    {
+        if( !_isCached( type ) && !hasSubscribers( type ))
+            return true;
+
+        const zeq::Event& event = producer();
+        assert( event.getType() == type );
+        return publish( event );
+    }
+
+    bool hasSubscribers( const uint128_t& type )
+    {
+        // The send thread owns the socket in asynchronous mode
+        if( _queue )
+            return _isSubscribed( type );
+
+        const SocketLock lock( *this );
+        return _hasSubscribers( type );
+    }
+
+    void setLastValueCache( const uint128_t& type, const bool enable )
+    {
+        // replays the last values while the application does not publish
+        if( enable && !_queue && !_thread.joinable( ))
+            _startThread( &Impl::_subscriptionLoop );
+
+        const SocketLock lock( *this );
+        TypeState& state = _types.get( type );
+        state.cached = enable;
+
+        // the send thread drops it with the next queued event of the type
+        if( !enable && !_queue )
+            state.lastValue = Item();
+    }
+
+    void setCompression( const uint128_t& type, const Compression compression,
+                         const size_t threshold )
+    {
+        if( !detail::isAvailable( compression ))
+            ZEQTHROW( std::runtime_error(
+                          "Compression codec is not available in this build" ));
+
+        TypeState& state = _types.get( type );
+        state.threshold = threshold;
+        state.compression = compression;
+    }
+
+    void setZeroCopy( const bool enable ) { _zeroCopy = enable; }
+    void setWireFormat( const WireFormat format ) { _format = format; }
+
+    void enableAsync( const size_t queueSize, const OverflowPolicy policy )
+    {
+        if( _queue )
+            ZEQTHROW( std::runtime_error( "Publisher is already asynchronous"));
+
+        // the send thread takes over the socket from the subscription thread
+        if( _thread.joinable( ))
+            _stopThread();
+
+        // Room for the events the send thread drops, see _sendLoop()
+        const bool dropOldest = policy == OVERFLOW_DROP_OLDEST;
+        _queue.reset( new Queue( dropOldest ? 2 * queueSize : queueSize ));
+        _maxQueued = dropOldest ? _queue->capacity() / 2 : _queue->capacity();
+        _policy = policy;
+        _startThread( &Impl::_sendLoop );
+    }
+
+    Stats getStats() const
+    {
+        Stats stats;
+        stats.queueDepth = _queue ? _queue->size() : 0;
+        stats.sent = _sent;
+        stats.dropped = _dropped;
+        stats.compressed = _compressedEvents;
+        stats.uncompressedBytes = _uncompressedBytes;
+        stats.compressedBytes = _compressedBytes;
+        stats.compressionTime = _compressionTime;
+        return stats;
+    }
+
+    const std::string& getSession() const { return _session; }
+
+private:
+    /** An event waiting in the send queue of an asynchronous publisher */
+    struct Item
+    {
+        Item() : size( 0 ) {}
+        Item( const uint128_t& type_, const ConstByteArray& data_,
+              const size_t size_ )
+            : type( type_ ), data( data_ ), size( size_ ) {}
+
+        uint128_t type;
+        ConstByteArray data;
+        size_t size;
+    };
+    typedef detail::BoundedQueue< Item > Queue;
+
+    /**
+     * Settings and subscriptions of an event type, read by publish() on any
+     * thread without locking. The socket owner, i.e., the send thread of an
+     * asynchronous publisher or else the application and the subscription
+     * thread, updates the subscriptions and the last value.
+     */
+    struct TypeState
+    {
+        TypeState()
+            : subscribed( false ), cached( false )
+            , compression( COMPRESSION_NONE ), threshold( 0 ) {}
+
+        std::atomic< bool > subscribed;
+        std::atomic< bool > cached;
+        std::atomic< Compression > compression;
+        std::atomic< size_t > threshold; // minimum payload size to compress
+        Item lastValue; // null data until first publish, socket owner only
+    };
+
+    bool _enqueue( const uint128_t& type, const ConstByteArray& data,
+                   const size_t size )
+    {
+        Item item( type, data, size );
+        while( !_queue->push( item ))
+        {
+            // The send thread drops the oldest events, unless it is behind by
+            // twice the queue size
+            if( _policy != OVERFLOW_BLOCK )
+            {
+                ++_dropped;
+                return false;
+            }
+
+            ++_producerWaiting;
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            std::unique_lock< std::mutex > lock( _mutex );
+            _producerCondition.wait( lock, [this]
+                { return _queue->size() < _queue->capacity(); });
+            --_producerWaiting;
+        }
+
+        // Pairs with the fence in _sendLoop(): either the send thread sees the
+        // new item, or we see that it is waiting for one. Only the producer
+        // resetting the flag wakes it up.
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if( _consumerWaiting && _consumerWaiting.exchange( false ))
+            _wakeUp();
+        return true;
+    }
+
+    /**
+     * Locks the socket against the subscription thread of a synchronous
+     * publisher, no-op otherwise. Subscriptions which arrived meanwhile are
+     * processed before unlocking: sending resets the file descriptor of the
+     * socket, the thread would not wake up for them.
+     */
+    class SocketLock
+    {
+    public:
+        explicit SocketLock( Impl& impl )
+            : _impl( impl._queue || !impl._thread.joinable() ? nullptr : &impl )
+        {
+            if( _impl )
+                _impl->_socketMutex.lock();
+        }
+
+        ~SocketLock()
+        {
+            if( !_impl )
+                return;
+            _impl->_drainSubscriptions();
+            _impl->_socketMutex.unlock();
+        }
+
+    private:
+        Impl* const _impl;
+    };
+
+    void _startThread( void ( Impl::*loop )( ))
+    {
+        if( !_wakeup )
+        {
+            const std::string address = "inproc://zeq.publisher." +
+                         std::to_string( reinterpret_cast< uintptr_t >( this ));
+            _wakeup = zmq_socket( getContext(), ZMQ_PULL );
+            _notify = zmq_socket( getContext(), ZMQ_PUSH );
+            if( zmq_bind( _wakeup, address.c_str( )) == -1 ||
+                zmq_connect( _notify, address.c_str( )) == -1 )
+            {
+                ZEQTHROW( std::runtime_error( "Cannot bind " + address + ": " +
+                                              zmq_strerror( zmq_errno( ))));
+            }
+        }
+
+        _running = true;
+        _thread = std::thread( std::bind( loop, this ));
+    }
+
+    void _stopThread()
+    {
+        _running = false;
+        _wakeUp();
+        _thread.join();
+    }
+
+    /** Interrupt the poll of the send or subscription thread */
+    void _wakeUp()
+    {
+        // the inproc socket is shared with _stopThread(), once per poll
+        std::lock_guard< std::mutex > lock( _mutex );
+        zmq_send( _notify, "", 0, ZMQ_DONTWAIT );
+    }
+
+    /**
+     * Process the subscriptions of a synchronous publisher with cached types,
+     * to replay the last values while the application does not publish.
+     */
+    void _subscriptionLoop()
+    {
+        // The socket is used by the application, only its descriptor is polled
+        zmq_pollitem_t items[2];
+        items[0].socket = _wakeup;
+        items[1].socket = 0;
+        {
+            std::lock_guard< std::mutex > lock( _socketMutex );
+            size_t size = sizeof( items[1].fd );
+            zmq_getsockopt( socket, ZMQ_FD, &items[1].fd, &size );
+        }
+        for( zmq_pollitem_t& item : items )
+            item.events = ZMQ_POLLIN;
+
+        while( _running )
+        {
+            {
+                std::lock_guard< std::mutex > lock( _socketMutex );
+                _drainSubscriptions();
+            }
+
+            items[0].revents = items[1].revents = 0;
+            if( zmq_poll( items, 2, -1 ) == -1 )
+                ZEQWARN << "Cannot wait for subscriptions, got "
+                        << zmq_strerror( zmq_errno( )) << std::endl;
+            while( zmq_recv( _wakeup, 0, 0, ZMQ_DONTWAIT ) != -1 ) {}
+        }
+    }
+
+    void _sendLoop()
+    {
+        zmq_pollitem_t items[2];
+        items[0].socket = _wakeup;
+        items[1].socket = socket;
+        for( zmq_pollitem_t& item : items )
+        {
+            item.fd = 0;
+            item.events = ZMQ_POLLIN;
+        }
+
+        Item item;
+        for( ;; )
+        {
+            _processSubscriptions();
+
+            // drain everything which is queued in one go, dropping the events
+            // older than the newest queue size ones
+            while( _queue->pop( item ))
+            {
+                if( _policy == OVERFLOW_DROP_OLDEST &&
+                    _queue->size() >= _maxQueued )
+                {
+                    ++_dropped;
+                    item = Item();
+                    continue;
+                }
+
+                _cache( item );
+                if( _isSubscribed( item.type ))
+                {
+                    _send( item );
+                    ++_sent;
+                }
+                item = Item();
+            }
+
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            if( _producerWaiting > 0 )
+            {
+                std::lock_guard< std::mutex > lock( _mutex );
+                _producerCondition.notify_all();
+            }
+
+            if( !_running && _queue->size() == 0 )
+                return;
+
+            // Sleep until an event is queued, a subscription arrives or the
+            // publisher is destroyed
+            _consumerWaiting = true;
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            if( _queue->size() == 0 && _running )
+            {
+                items[0].revents = items[1].revents = 0;
+                if( zmq_poll( items, 2, -1 ) == -1 )
+                    ZEQWARN << "Cannot wait for events to send, got "
+                            << zmq_strerror( zmq_errno( )) << std::endl;
+                while( zmq_recv( _wakeup, 0, 0, ZMQ_DONTWAIT ) != -1 ) {}
+            }
+            _consumerWaiting = false;
+        }
+    }
+
+    bool _send( const Item& item )
+    {
+        if( _useZeroCopy( item.type, item.size ))
+        {
+            return _sendHeader( item.type, true ) &&
+                   _sendData( item.data, item.size );
+        }
+        return _send( item.type, item.data.get(), item.size );
+    }
+
+    bool _isCached( const uint128_t& type ) const
+    {
+        const TypeState* state = _types.find( type );
+        return state && state->cached;
+    }
+
+    bool _isSubscribed( const uint128_t& type ) const
+    {
+        if( _anyPrefix )
+            return true;
+        const TypeState* state = _types.find( type );
+        return state && state->subscribed;
+    }
+
+    void _cache( const Item& item )
+    {
+        TypeState* state = _types.find( item.type );
+        if( !state )
+            return;
+
+        if( state->cached )
+            state->lastValue = item;
+        else if( state->lastValue.data ) // cache disabled since
+            state->lastValue = Item();
+    }
+
+    /**
+     * Send the last value of the type in the given replay topic to the one
+     * subscriber which subscribed to the topic.
+     */
+    void _replayLastValue( const uint8_t* topic )
+    {
+        uint128_t type;
+        ::memcpy( &type, topic + sizeof( type ), sizeof( type ));
+#ifndef COMMON_LITTLEENDIAN
+        detail::byteswap( type ); // convert from little endian wire
+#endif
+        const TypeState* state = _types.find( type );
+        if( !state || !state->cached || !state->lastValue.data )
+            return;
+
+        // The replay topic replaces the type in the header frame, followed by
+        // the codec and size of compressed payloads as for other events
+        const Item& item = state->lastValue;
+        const Compression compression = _getCompression( type, item.size );
+        const size_t compressedSize = compression == COMPRESSION_NONE ? 0 :
+                            _compress( compression, item.data.get(), item.size );
+
+        uint32_t codec = compression;
+        uint64_t size = item.size;
+#ifndef COMMON_LITTLEENDIAN
+        detail::byteswap( codec );
+        detail::byteswap( size );
 #endif
         zmq_msg_t msgHeader;
-        zmq_msg_init_size( &msgHeader, sizeof( type ));
-        memcpy( zmq_msg_data( &msgHeader ), &type, sizeof( type ));
-        int ret = zmq_msg_send( &msgHeader, socket,
-                                event.getSize() > 0 ? ZMQ_SNDMORE : 0 );
-        zmq_msg_close( &msgHeader );
-        if( ret == -1 )
+        zmq_msg_init_size( &msgHeader, REPLAY_TOPIC_SIZE +
+                          ( compressedSize > 0 ? sizeof( codec ) + sizeof( size )
+                                               : 0 ));
+        uint8_t* ptr = static_cast< uint8_t* >( zmq_msg_data( &msgHeader ));
+        ::memcpy( ptr, topic, REPLAY_TOPIC_SIZE );
+        if( compressedSize > 0 )
         {
-            ZEQWARN << "Cannot publish message header, got "
-                   << zmq_strerror( zmq_errno( )) << std::endl;
-            return false;
+            ::memcpy( ptr + REPLAY_TOPIC_SIZE, &codec, sizeof( codec ));
+            ::memcpy( ptr + REPLAY_TOPIC_SIZE + sizeof( codec ), &size,
+                      sizeof( size ));
         }
 
-        if( event.getSize() == 0 )
-            return true;
+        if( !_sendHeader( msgHeader, item.size > 0 ? ZMQ_SNDMORE : 0 ) ||
+            item.size == 0 )
+        {
+            return;
+        }
+        if( compressedSize > 0 )
+            _sendData( _compressed.data(), compressedSize );
+        else // cached payloads are immutable, share instead of copying them
+            _sendData( item.data, item.size );
+    }
 
+    /**
+     * Update the subscribed types from the XPUB subscription messages and
+     * replay the last values to new subscribers.
+     */
+    void _processSubscriptions()
+    {
         zmq_msg_t msg;
-        zmq_msg_init_size( &msg, event.getSize( ));
-        memcpy( zmq_msg_data(&msg), event.getData(), event.getSize( ));
-        ret = zmq_msg_send( &msg, socket, 0 );
+        zmq_msg_init( &msg );
+        while( zmq_msg_recv( &msg, socket, ZMQ_DONTWAIT ) != -1 )
+        {
+            // first byte is 1 for subscribe and 0 for unsubscribe, the topic
+            // follows. The XPUB forwards only the first subscription and the
+            // last unsubscription of each topic, a set is sufficient.
+            const uint8_t* data =
+                static_cast< const uint8_t* >( zmq_msg_data( &msg ));
+            const size_t size = zmq_msg_size( &msg );
+            if( size == 0 )
+                continue;
+
+            const bool subscribe = data[0] == 1;
+            if( size == 1 + REPLAY_TOPIC_SIZE )
+            {
+                if( subscribe )
+                    _replayLastValue( data + 1 );
+                continue;
+            }
+
+            if( size != 1 + sizeof( uint128_t ))
+            {
+                // not a zeq event type, assume it matches everything
+                const std::string prefix( data + 1, data + size );
+                if( subscribe )
+                    _prefixSubscriptions.insert( prefix );
+                else
+                    _prefixSubscriptions.erase( prefix );
+                _anyPrefix = !_prefixSubscriptions.empty();
+                continue;
+            }
+
+            uint128_t type;
+            ::memcpy( &type, data + 1, sizeof( type ));
+#ifndef COMMON_LITTLEENDIAN
+            detail::byteswap( type ); // convert from little endian wire
+#endif
+            _types.get( type ).subscribed = subscribe;
+        }
         zmq_msg_close( &msg );
-        if( ret  == -1 )
+    }
+
+    /** Process subscriptions until the socket has no input left */
+    void _drainSubscriptions()
+    {
+        // ZMQ_EVENTS also resets the file descriptor of the socket
+        int events = 0;
+        size_t size = sizeof( events );
+        do
         {
-            ZEQWARN << "Cannot publish message data, got "
-                    << zmq_strerror( zmq_errno( )) << std::endl;
-            return false;
+            _processSubscriptions();
+            if( zmq_getsockopt( socket, ZMQ_EVENTS, &events, &size ) == -1 )
+                return;
         }
-        return true;
+        while( events & ZMQ_POLLIN );
     }
 
-    bool publish( const servus::Serializable& serializable )
+    bool _hasSubscribers( const uint128_t& type )
     {
-#ifdef COMMON_LITTLEENDIAN
-        const uint128_t& type = serializable.getTypeIdentifier();
-#else
-        uint128_t type = serializable.getTypeIdentifier();
+        _processSubscriptions();
+        return _isSubscribed( type );
+    }
+
+    bool _useZeroCopy( const uint128_t& type, const size_t size )
+    {
+        // compressed payloads are sent from a temporary buffer
+        return _zeroCopy && size >= ZERO_COPY_THRESHOLD &&
+               _getCompression( type, size ) == COMPRESSION_NONE;
+    }
+
+    Compression _getCompression( const uint128_t& type, const size_t size )
+    {
+        if( size == 0 )
+            return COMPRESSION_NONE;
+
+        const TypeState* state = _types.find( type );
+        if( !state || size < state->threshold )
+            return COMPRESSION_NONE;
+        return state->compression;
+    }
+
+    /**
+     * Compress the given payload into _compressed.
+     * @return the compressed size, 0 if compression did not reduce the size
+     */
+    size_t _compress( const Compression compression, const void* data,
+                      const size_t size )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        _compressed.resize( detail::getMaxCompressedSize( compression, size ));
+        const size_t compressedSize =
+            detail::compress( compression, data, size, _compressed.data(),
+                              _compressed.size( ));
+        _compressionTime +=
+            std::chrono::duration_cast< std::chrono::microseconds >(
+                std::chrono::steady_clock::now() - start ).count();
+
+        // e.g., already compressed JPEG data
+        if( compressedSize == 0 || compressedSize >= size )
+            return 0;
+        // subscribers reject it as a forged size
+        if( size / compressedSize >= detail::MAX_COMPRESSION_RATIO )
+            return 0;
+
+        ++_compressedEvents;
+        _uncompressedBytes += size;
+        _compressedBytes += compressedSize;
+        return compressedSize;
+    }
+
+    bool _send( const uint128_t& type, const void* data, const size_t size )
+    {
+        const Compression compression = _getCompression( type, size );
+        if( compression != COMPRESSION_NONE )
+        {
+            const size_t compressedSize = _compress( compression, data, size );
+            if( compressedSize > 0 )
+                return _sendHeader( type, compression, size ) &&
+                       _sendData( _compressed.data(), compressedSize );
+        }
+
+        if( _format == FORMAT_SINGLE_FRAME )
+            return _sendFrame( type, data, size );
+
+        if( !_sendHeader( type, size > 0 ))
+            return false;
+        return size == 0 || _sendData( data, size );
+    }
+
+    bool _sendFrame( uint128_t type, const void* data, const size_t size )
+    {
+#ifndef COMMON_LITTLEENDIAN
         detail::byteswap( type ); // convert to little endian wire protocol
 #endif
-        const servus::Serializable::Data& data = serializable.toBinary();
-        const bool hasPayload = data.ptr && data.size > 0;
+        // The type stays the frame prefix, so topic filtering still works
+        zmq_msg_t msg;
+        zmq_msg_init_size( &msg, sizeof( type ) + size );
+        uint8_t* ptr = static_cast< uint8_t* >( zmq_msg_data( &msg ));
+        ::memcpy( ptr, &type, sizeof( type ));
+        if( size > 0 )
+            ::memcpy( ptr + sizeof( type ), data, size );
+        return _sendData( msg );
+    }
 
+    bool _sendHeader( uint128_t type, const bool hasPayload )
+    {
+#ifndef COMMON_LITTLEENDIAN
+        detail::byteswap( type ); // convert to little endian wire protocol
+#endif
         zmq_msg_t msgHeader;
         zmq_msg_init_size( &msgHeader, sizeof( type ));
         memcpy( zmq_msg_data( &msgHeader ), &type, sizeof( type ));
-        int ret = zmq_msg_send( &msgHeader, socket,
-                                hasPayload ? ZMQ_SNDMORE : 0 );
+        return _sendHeader( msgHeader, hasPayload ? ZMQ_SNDMORE : 0 );
+    }
+
+    /** Send the extended header of a compressed event */
+    bool _sendHeader( uint128_t type, const Compression compression,
+                      uint64_t size )
+    {
+        uint32_t codec = compression;
+#ifndef COMMON_LITTLEENDIAN
+        detail::byteswap( type ); // convert to little endian wire protocol
+        detail::byteswap( codec );
+        detail::byteswap( size );
+#endif
+        zmq_msg_t msgHeader;
+        zmq_msg_init_size( &msgHeader, detail::COMPRESSED_HEADER_SIZE );
+        uint8_t* ptr = static_cast< uint8_t* >( zmq_msg_data( &msgHeader ));
+        ::memcpy( ptr, &type, sizeof( type ));
+        ::memcpy( ptr + sizeof( type ), &codec, sizeof( codec ));
+        ::memcpy( ptr + sizeof( type ) + sizeof( codec ), &size,
+                  sizeof( size ));
+        return _sendHeader( msgHeader, ZMQ_SNDMORE );
+    }
+
+    bool _sendHeader( zmq_msg_t& msgHeader, const int flags )
+    {
+        const int ret = zmq_msg_send( &msgHeader, socket, flags );
         zmq_msg_close( &msgHeader );
         if( ret == -1 )
         {
@@ -175,14 +816,30 @@ public:
                    << zmq_strerror( zmq_errno( )) << std::endl;
             return false;
         }
+        return true;
+    }
 
-        if( !hasPayload )
-            return true;
+    bool _sendData( const void* data, const size_t size )
+    {
+        zmq_msg_t msg;
+        zmq_msg_init_size( &msg, size );
+        ::memcpy( zmq_msg_data( &msg ), data, size );
+        return _sendData( msg );
+    }
 
+    bool _sendData( const ConstByteArray& data, const size_t size )
+    {
+        // The copy of the shared pointer keeps the buffer alive until ZeroMQ
+        // has sent it and calls _releaseBuffer() from its I/O thread.
         zmq_msg_t msg;
-        zmq_msg_init_size( &msg, data.size );
-        ::memcpy( zmq_msg_data(&msg), data.ptr.get(), data.size );
-        ret = zmq_msg_send( &msg, socket, 0 );
+        zmq_msg_init_data( &msg, const_cast< uint8_t* >( data.get( )), size,
+                           _releaseBuffer, new ConstByteArray( data ));
+        return _sendData( msg );
+    }
+
+    bool _sendData( zmq_msg_t& msg )
+    {
+        const int ret = zmq_msg_send( &msg, socket, 0 );
         zmq_msg_close( &msg );
         if( ret  == -1 )
         {
@@ -193,9 +850,19 @@ public:
         return true;
     }
 
-    const std::string& getSession() const { return _session; }
+    static void _releaseBuffer( void*, void* hint )
+    {
+        delete static_cast< ConstByteArray* >( hint );
+    }
+
+    static ConstByteArray _copy( const servus::Serializable::Data& data )
+    {
+        if( !data.ptr || data.size == 0 )
+            return ConstByteArray();
+        return detail::BufferPool::getInstance().copy( data.ptr.get(),
+                                                       data.size );
+    }
 
-private:
     void _initService( const uint32_t announceMode = ANNOUNCE_REQUIRED )
     {
         if( !( announceMode & (ANNOUNCE_ZEROCONF | ANNOUNCE_REQUIRED) ))
@@ -228,6 +895,39 @@ private:
 
     servus::Servus _service;
     const std::string _session;
+    bool _zeroCopy;
+    WireFormat _format;
+
+    // asynchronous mode
+    std::unique_ptr< Queue > _queue;
+    OverflowPolicy _policy;
+    size_t _maxQueued; // before the send thread drops the oldest events
+    std::thread _thread;
+    void* _wakeup; // inproc socket polled by the send/subscription thread
+    void* _notify; // inproc socket of the producers, locked by _mutex
+    std::mutex _mutex;
+    std::condition_variable _producerCondition;
+    std::atomic< bool > _running;
+    std::atomic< size_t > _producerWaiting;
+    std::atomic< bool > _consumerWaiting;
+    std::atomic< uint64_t > _sent;
+    std::atomic< uint64_t > _dropped;
+
+    // used by the application and the subscription thread of a synchronous
+    // publisher with cached types
+    std::mutex _socketMutex;
+
+    // _compressed is used by the sending thread
+    std::vector< uint8_t > _compressed;
+    std::atomic< uint64_t > _compressedEvents;
+    std::atomic< uint64_t > _uncompressedBytes;
+    std::atomic< uint64_t > _compressedBytes;
+    std::atomic< uint64_t > _compressionTime;
+
+    // subscriptions, caching and compression per event type
+    detail::TypeTable< TypeState > _types;
+    std::unordered_set< std::string > _prefixSubscriptions; // socket owner
+    std::atomic< bool > _anyPrefix;
 };
 
 Publisher::Publisher()
@@ -268,6 +968,55 @@ bool Publisher::publish( const servus::Serializable& serializable )
     return _impl->publish( serializable );
 }
 
+bool Publisher::publish( const uint128_t& type,
+                         const EventProducer& producer )
+{
+    return _impl->publish( type, producer );
+}
+
+bool Publisher::hasSubscribers( const uint128_t& type ) const
+{
+    return _impl->hasSubscribers( type );
+}
+
+void Publisher::setLastValueCache( const uint128_t& type, const bool enable )
+{
+    _impl->setLastValueCache( type, enable );
+}
+
+void Publisher::setCompression( const uint128_t& type,
+                                const Compression compression,
+                                const size_t threshold )
+{
+    _impl->setCompression( type, compression, threshold );
+}
+
+bool Publisher::isAvailable( const Compression compression )
+{
+    return detail::isAvailable( compression );
+}
+
+void Publisher::setZeroCopy( const bool enable )
+{
+    _impl->setZeroCopy( enable );
+}
+
+void Publisher::setWireFormat( const WireFormat format )
+{
+    _impl->setWireFormat( format );
+}
+
+void Publisher::enableAsync( const size_t queueSize,
+                             const OverflowPolicy policy )
+{
+    _impl->enableAsync( queueSize, policy );
+}
+
+Publisher::Stats Publisher::getStats() const
+{
+    return _impl->getStats();
+}
+
 std::string Publisher::getAddress() const
 {
     return _impl->getAddress();
@@ -21,11 +21,30 @@ namespace zeq
  * The session is tied to ZeroConf announcement and can be disabled by passing
  * zeq::NULL_SESSION as the session name.
  *
+ * Not thread safe, unless the publisher is asynchronous (see enableAsync()) in
+ * which case publish() may be called from any thread.
+ *
  * Example: @include tests/publisher.cpp
  */
 class Publisher
 {
 public:
+    /**
+     * Counters of a publisher, see enableAsync() and setCompression().
+     *
+     * The compression ratio is uncompressedBytes / compressedBytes.
+     */
+    struct Stats
+    {
+        size_t queueDepth; //!< events currently waiting to be sent
+        uint64_t sent; //!< events sent by the send thread
+        uint64_t dropped; //!< events dropped due to a full send queue
+        uint64_t compressed; //!< events sent compressed
+        uint64_t uncompressedBytes; //!< payload size of compressed events
+        uint64_t compressedBytes; //!< sent size of compressed events
+        uint64_t compressionTime; //!< time spent compressing, in microseconds
+    };
+
     /**
      * Create a default publisher.
      *
@@ -100,13 +119,154 @@ public:
     /**
      * Publish the given serializable object to any subscriber.
      *
-     * If there is no subscriber for that serializable, no event will be sent.
+     * If there is no subscriber for that serializable, no event will be sent
+     * and the serializable is not serialized.
      *
      * @param serializable the object to publish
      * @return true if publish was successful
      */
     ZEQ_API bool publish( const servus::Serializable& serializable );
 
+    /**
+     * Publish an event created on demand to any subscriber.
+     *
+     * The producer is only called if at least one connected subscriber is
+     * subscribed to the given type, which saves the serialization cost for
+     * events nobody listens to.
+     *
+     * @param type the type of the event created by the producer
+     * @param producer the function serializing the event of the given type
+     * @return true if publish was successful or no subscriber wants the event
+     */
+    ZEQ_API bool publish( const uint128_t& type,
+                          const EventProducer& producer );
+
+    /**
+     * Check if any connected subscriber is subscribed to the given type.
+     *
+     * Subscriptions are tracked from the subscription messages of the
+     * subscribers, so a newly connected subscriber may not be visible
+     * immediately. The send thread of an asynchronous publisher updates them
+     * as they arrive, and this call does not lock.
+     *
+     * @param type the event type of interest
+     * @return true if at least one subscriber wants events of the type
+     */
+    ZEQ_API bool hasSubscribers( const uint128_t& type ) const;
+
+    /**
+     * Enable or disable the last-value cache for the given event type.
+     *
+     * The publisher keeps the most recently published payload of each cached
+     * type, also while nobody is subscribed, and sends it again as soon as a
+     * new subscription for that type arrives. Late-joining subscribers thus
+     * receive the current state without the application republishing it.
+     * The payload is shared, not copied or re-serialized; the data of a
+     * published Event must not be modified afterwards.
+     *
+     * Only the new subscriber receives the cached value, subscribers older
+     * than zeq 0.5 do not ask for it. The send thread of an asynchronous
+     * publisher replays it, a synchronous publisher starts a thread for this
+     * on the first cached type, so that new subscribers are served while the
+     * application does not publish. Disabled by default.
+     *
+     * @param type the event type to cache
+     * @param enable true to cache the last value, false to drop it
+     */
+    ZEQ_API void setLastValueCache( const uint128_t& type, bool enable );
+
+    /**
+     * Enable or disable zero-copy publishing of large events.
+     *
+     * In zero-copy mode, payloads of a few kilobytes and more are handed to
+     * ZeroMQ without copying them. The publisher shares ownership of the event
+     * data with ZeroMQ until it has been sent, so the published Event may be
+     * destroyed right after publish() returns, but its data must not be
+     * modified afterwards. Serializables do not hand out ownership of their
+     * data, it is copied once when it has to outlive publish(). Disabled by
+     * default.
+     *
+     * @param enable true to publish large payloads without copying them
+     */
+    ZEQ_API void setZeroCopy( bool enable );
+
+    /**
+     * Compress large payloads of the given event type.
+     *
+     * Payloads of at least threshold bytes are compressed before they are sent,
+     * unless compression does not reduce their size, e.g., for JPEG images, or
+     * reduces it by more than 1024 times, which subscribers reject to bound
+     * their memory use. Subscribers decompress them transparently, but
+     * subscribers older than zeq 0.5 cannot read compressed events. Compressed
+     * events are always sent as two frames, and compression takes precedence
+     * over zero-copy mode. An asynchronous publisher compresses in its send
+     * thread. Disabled by default.
+     *
+     * @param type the event type to compress
+     * @param compression the codec to use, COMPRESSION_NONE to disable
+     * @param threshold the minimum payload size in bytes to compress
+     * @throw std::runtime_error if the codec is not available, see
+     *        isAvailable()
+     */
+    ZEQ_API void setCompression( const uint128_t& type, Compression compression,
+                                 size_t threshold = 4096 );
+
+    /** @return true if zeq was built with the given compression codec */
+    ZEQ_API static bool isAvailable( Compression compression );
+
+    /**
+     * Select the encoding of published events.
+     *
+     * FORMAT_SINGLE_FRAME halves the number of ZeroMQ frames per event, which
+     * dominates the cost of small, high-frequency events. Subscribers accept
+     * both formats, but subscribers older than zeq 0.5 only understand
+     * FORMAT_TWO_FRAMES, which is the default. Payloads published in zero-copy
+     * mode are always sent as two frames.
+     *
+     * The format is not negotiated with the subscribers: ZeroMQ does not tell
+     * a publisher which subscribers it has, it only forwards the first
+     * subscription to each event type. Only select FORMAT_SINGLE_FRAME if all
+     * subscribers use zeq 0.5 or later, older ones receive the events of this
+     * publisher without payload.
+     *
+     * @param format the wire format for all following publish() calls
+     */
+    ZEQ_API void setWireFormat( WireFormat format );
+
+    /**
+     * Make this publisher asynchronous.
+     *
+     * Afterwards publish() only enqueues the event into a bounded, lock-free
+     * queue, which may be filled from any number of threads. A dedicated send
+     * thread drains the queue to the socket. The payload of a published Event
+     * is shared with the queue instead of being copied, so its data must not
+     * be modified after publish(). Serializables are serialized and copied in
+     * the calling thread.
+     *
+     * The publisher is to be configured before this call, and it stays
+     * asynchronous until it is destroyed. Queued events are sent before the
+     * destructor returns.
+     *
+     * @param queueSize the capacity of the send queue, rounded up to the next
+     *                  power of two.
+     * @param policy the behaviour of publish() when the queue is full. With
+     *               OVERFLOW_DROP_NEWEST publish() returns false for a dropped
+     *               event. With OVERFLOW_DROP_OLDEST the queue has room for
+     *               twice the given size, and the send thread drops the events
+     *               older than the newest queueSize ones. Only if it falls
+     *               behind by the full queue, publish() drops the new event and
+     *               returns false.
+     * @throw std::runtime_error if the publisher is already asynchronous
+     */
+    ZEQ_API void enableAsync( size_t queueSize = 1024,
+                              OverflowPolicy policy = OVERFLOW_BLOCK );
+
+    /**
+     * @return the compression and send queue counters, the latter are zero if
+     *         not asynchronous
+     */
+    ZEQ_API Stats getStats() const;
+
     /**
      * Get the publisher URI.
      *
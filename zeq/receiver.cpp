@@ -8,139 +8,356 @@
 
 #include "receiver.h"
 #include "log.h"
+#include "detail/smallVector.h"
 #include "detail/socket.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <deque>
 #include <stdexcept>
+#include <thread>
 
 namespace zeq
 {
 namespace detail
 {
+/** Limits of a drain, 0 for no limit */
+struct Budget
+{
+    size_t events; //!< maximum number of events reported by process()
+    uint32_t time; //!< maximum processing time in microseconds
+};
+
 class Receiver
 {
 public:
     Receiver()
         : _context( zmq_ctx_new( ))
-    {}
+        , _wakeupURI( "inproc://zeq.receiver." +
+                      std::to_string( reinterpret_cast< uintptr_t >( this )))
+        , _wakeup( zmq_socket( _context, ZMQ_PULL ))
+        , _stopping( false )
+        , _dirty( true )
+    {
+        if( zmq_bind( _wakeup, _wakeupURI.c_str( )) == -1 )
+        {
+            const std::string error = zmq_strerror( zmq_errno( ));
+            zmq_close( _wakeup );
+            zmq_ctx_destroy( _context );
+            ZEQTHROW( std::runtime_error( "Cannot bind " + _wakeupURI + ": " +
+                                          error ));
+        }
+    }
 
     ~Receiver()
     {
+        stop();
+        zmq_close( _wakeup );
         zmq_ctx_destroy( _context );
     }
 
     void add( ::zeq::Receiver* receiver )
     {
+        // the thread would use the receiver before it is constructed
+        if( isRunning( ))
+            ZEQTHROW( std::runtime_error( "Cannot join a running receiver" ));
+
         _shared.push_back( receiver );
+        _dirty = true;
     }
 
     void remove( ::zeq::Receiver* receiver )
     {
-        _shared.erase( std::remove( _shared.begin(), _shared.end(), receiver ),
-                       _shared.end( ));
-    }
+        const Receivers::iterator i = std::find( _shared.begin(),
+                                                 _shared.end(), receiver );
+        if( i == _shared.end( ))
+            return;
 
-    bool receive( const uint32_t timeout )
-    {
-        if( timeout == TIMEOUT_INDEFINITE )
-            return _receive();
+        // the thread iterates the receivers, continue without this one
+        const bool running = isRunning();
+        const Executor executor = _executor;
+        stop();
 
-        // Never fully block. Give receivers a chance to update, e.g., to check
-        // for new connections from zeroconf (#20)
-        const uint32_t block = std::min( 1000u, timeout / 10 );
+        _shared.erase( i );
+        _dirty = true;
+
+        if( running && !_shared.empty( ))
+            start( executor );
+    }
 
+    size_t receive( const uint32_t timeout, const Budget* budget )
+    {
         const auto startTime = std::chrono::high_resolution_clock::now();
+        uint32_t wait = timeout;
         while( true )
         {
             for( ::zeq::Receiver* receiver : _shared )
                 receiver->update();
 
+            // Blocks until data arrives, the timeout expired or a receiver
+            // asked for an update, e.g., for a new publisher from zeroconf
+            const size_t received = _receive( wait, budget );
+            if( received > 0 )
+                return received;
+
+            if( _stopping )
+                return 0;
+
+            if( timeout == TIMEOUT_INDEFINITE )
+                continue;
+
             const auto endTime = std::chrono::high_resolution_clock::now();
             const uint32_t elapsed =
                 std::chrono::nanoseconds( endTime - startTime ).count() /
                 1000000;
-            uint32_t wait = 0;
-            if( elapsed < timeout )
-                wait = std::min( timeout - uint32_t( elapsed ), block );
+            if( elapsed >= timeout )
+                return 0;
+            wait = timeout - elapsed;
+        }
+    }
+
+    bool wait( void* socket, const uint32_t timeout )
+    {
+        zmq_pollitem_t items[2];
+        items[0].socket = _wakeup;
+        items[1].socket = socket;
+        for( zmq_pollitem_t& item : items )
+        {
+            item.fd = 0;
+            item.events = ZMQ_POLLIN;
+        }
+
+        const auto startTime = std::chrono::steady_clock::now();
+        for( ;; )
+        {
+            long wait = -1;
+            if( timeout != TIMEOUT_INDEFINITE )
+            {
+                const long elapsed =
+                    std::chrono::duration_cast< std::chrono::milliseconds >(
+                        std::chrono::steady_clock::now() - startTime ).count();
+                wait = std::max( 0l, long( timeout ) - elapsed );
+            }
 
-            if( _receive( wait ))
+            items[0].revents = items[1].revents = 0;
+            if( zmq_poll( items, 2, wait ) == -1 )
+            {
+                ZEQTHROW( std::runtime_error( std::string( "Poll error: " ) +
+                                              zmq_strerror( zmq_errno( ))));
+            }
+            if( items[1].revents & ZMQ_POLLIN )
                 return true;
+            if( !( items[0].revents & ZMQ_POLLIN ))
+                return false; // timeout
 
-            if( elapsed >= timeout )
-                return false;
+            // e.g., a new publisher from zeroconf to connect to
+            while( zmq_recv( _wakeup, 0, 0, ZMQ_DONTWAIT ) != -1 ) {}
+            for( ::zeq::Receiver* receiver : _shared )
+                receiver->update();
         }
     }
 
+    FileDescriptors getFileDescriptors()
+    {
+        _updateSockets();
+
+        FileDescriptors descriptors;
+        for( const Socket& socket : _sockets )
+        {
+            if( !socket.socket ) // plain file descriptor
+            {
+                descriptors.push_back( socket.fd );
+                continue;
+            }
+
+            FileDescriptor descriptor;
+            size_t size = sizeof( descriptor );
+            if( zmq_getsockopt( socket.socket, ZMQ_FD, &descriptor,
+                                &size ) == -1 )
+            {
+                ZEQTHROW( std::runtime_error(
+                              std::string( "Cannot get file descriptor: " ) +
+                              zmq_strerror( zmq_errno( ))));
+            }
+            descriptors.push_back( descriptor );
+        }
+        return descriptors;
+    }
+
+    size_t processReady()
+    {
+        // Drain everything, the descriptors only signal again on new data
+        const Budget unlimited = { 0, 0 };
+        const size_t processed = _receive( 0, &unlimited );
+
+        // after consuming the wakeups
+        for( ::zeq::Receiver* receiver : _shared )
+            receiver->update();
+        return processed;
+    }
+
+    void start( const Executor& executor )
+    {
+        if( _thread.joinable( ))
+            ZEQTHROW( std::runtime_error( "Receiver is already running" ));
+
+        _executor = executor;
+        _stopping = false;
+        _thread = std::thread( [this]
+        {
+            while( !_stopping )
+                receive( TIMEOUT_INDEFINITE, nullptr );
+        });
+    }
+
+    void stop()
+    {
+        if( !_thread.joinable( ))
+            return;
+
+        // The wakeup socket doubles as control socket, the receive thread
+        // checks _stopping after being woken up.
+        _stopping = true;
+        void* control = zmq_socket( _context, ZMQ_PUSH );
+        zmq_connect( control, _wakeupURI.c_str( ));
+        zmq_send( control, 0, 0, 0 );
+        zmq_close( control );
+
+        _thread.join();
+        _executor = Executor();
+    }
+
+    bool isRunning() const { return _thread.joinable(); }
+
     void* getZMQContext() { return _context; }
+    const std::string& getWakeupURI() const { return _wakeupURI; }
+    const Executor& getExecutor() const { return _executor; }
 
 private:
     void* _context;
+    const std::string _wakeupURI;
+    void* _wakeup; // signalled by receivers to call update()
+
+    // Background receive, see zeq::Receiver::start()
+    std::thread _thread;
+    std::atomic< bool > _stopping;
+    Executor _executor;
     typedef std::vector< ::zeq::Receiver* > Receivers;
-    typedef Receivers::iterator ReceiversIter;
+    // Copies of the signalled sockets of one poll. Local to each receive, as
+    // handlers may receive again, which may rebuild the poll set.
+    typedef SmallVector< std::pair< Socket, ::zeq::Receiver* >, 8 >
+        ReadySockets;
 
     Receivers _shared;
 
-    bool _receive()
+    // Poll set of the wakeup socket followed by the sockets of all shared
+    // receivers, rebuilt only if _dirty
+    std::vector< Socket > _sockets;
+    Receivers _owners; // receiver of each socket in _sockets
+    bool _dirty;
+
+    void _updateSockets()
     {
-        while( true )
-        {
-            for( ::zeq::Receiver* receiver : _shared )
-                receiver->update();
+        if( !_dirty )
+            return;
 
-            // Never fully block. Give receivers a chance to update, e.g., to
-            // check for new connections from zeroconf (#20)
-            if( _receive( 1000 ))
-                return true;
+        Socket wakeup;
+        wakeup.socket = _wakeup;
+        wakeup.events = ZMQ_POLLIN;
+        _sockets.assign( 1, wakeup );
+        _owners.assign( 1, nullptr );
+        for( ::zeq::Receiver* receiver : _shared )
+        {
+            receiver->addSockets( _sockets );
+            _owners.resize( _sockets.size(), receiver );
         }
+        _dirty = false;
     }
 
-    bool _receive( const uint32_t timeout )
+    size_t _receive( const uint32_t timeout, const Budget* budget )
     {
-        std::vector< Socket > sockets;
-        std::deque< size_t > intervals;
-        for( ::zeq::Receiver* receiver : _shared )
-        {
-            const size_t before = sockets.size();
-            receiver->addSockets( sockets );
-            intervals.push_back( sockets.size() - before );
-        }
+        _updateSockets();
 
-        switch( zmq_poll( sockets.data(), int( sockets.size( )),
+        switch( zmq_poll( _sockets.data(), int( _sockets.size( )),
                           timeout == TIMEOUT_INDEFINITE ? -1 : timeout ))
         {
         case -1: // error
             ZEQTHROW( std::runtime_error( std::string( "Poll error: " ) +
                                           zmq_strerror( zmq_errno( ))));
         case 0: // timeout; no events signaled during poll
-            return false;
+            return 0;
 
         default:
         {
-            // For each event, find the subscriber which supplied the socket and
-            // inform it in case there is data on the socket. We saved #sockets
-            // for each subscriber above and track them down here as we iterate
-            // over all sockets:
-            ReceiversIter i = _shared.begin();
-            size_t interval = intervals.front();
-            intervals.pop_front();
-
-            for( Socket& socket : sockets )
+            // Consume wakeups, the caller updates the receivers and polls again
+            if( _sockets[0].revents & ZMQ_POLLIN )
+            {
+                while( zmq_recv( _wakeup, 0, 0, ZMQ_DONTWAIT ) != -1 ) {}
+            }
+
+            // For each event, inform the receiver which supplied the socket.
+            // Collect them first, process() may change the poll set.
+            ReadySockets ready;
+            for( size_t i = 1; i < _sockets.size(); ++i )
+            {
+                if( _sockets[i].revents & ZMQ_POLLIN )
+                    ready.push_back( std::make_pair( _sockets[i],
+                                                     _owners[i] ));
+            }
+
+            if( budget )
+                return _drain( ready, *budget );
+
+            size_t processed = 0;
+            for( auto& entry : ready )
+                processed += entry.second->process( entry.first );
+            return processed;
+        }
+        }
+    }
+
+    /**
+     * Process the ready sockets round-robin without polling again, until all
+     * are drained or the budget is spent. The budget counts the events
+     * reported by the receivers, a conflating subscriber may process several
+     * in one call.
+     */
+    size_t _drain( ReadySockets& ready, const Budget& budget )
+    {
+        typedef std::chrono::high_resolution_clock Clock;
+        const auto deadline = Clock::now() +
+                              std::chrono::microseconds( budget.time );
+        size_t processed = 0;
+        while( !ready.empty( ))
+        {
+            for( ReadySockets::iterator i = ready.begin(); i != ready.end(); )
             {
-                while( interval == 0 || interval-- == 0 )
+                processed += i->second->process( i->first );
+
+                if(( budget.events > 0 && processed >= budget.events ) ||
+                   ( budget.time > 0 && Clock::now() >= deadline ))
                 {
-                    ++i;
-                    interval = intervals.front();
-                    intervals.pop_front();
+                    return processed;
                 }
 
-                if( socket.revents & ZMQ_POLLIN )
-                    (*i)->process( socket );
+                if( _hasPending( i->first ))
+                    ++i;
+                else
+                    i = ready.erase( i );
             }
-            return true;
-        }
         }
+        return processed;
+    }
+
+    static bool _hasPending( const Socket& socket )
+    {
+        if( !socket.socket ) // plain file descriptor
+            return false;
+
+        int events = 0;
+        size_t size = sizeof( events );
+        return zmq_getsockopt( socket.socket, ZMQ_EVENTS, &events,
+                               &size ) == 0 && ( events & ZMQ_POLLIN );
     }
 };
 }
@@ -159,12 +376,64 @@ Receiver::Receiver( Receiver& shared )
 
 Receiver::~Receiver()
 {
-    _impl->remove( this );
+    leaveGroup(); // if a derived class did not already
 }
 
 bool Receiver::receive( const uint32_t timeout )
 {
-    return _impl->receive( timeout );
+    return _impl->receive( timeout, nullptr ) > 0;
+}
+
+size_t Receiver::drain( const uint32_t timeout, const size_t maxEvents,
+                        const uint32_t maxTime )
+{
+    const detail::Budget budget = { maxEvents, maxTime };
+    return _impl->receive( timeout, &budget );
+}
+
+FileDescriptors Receiver::getFileDescriptors()
+{
+    return _impl->getFileDescriptors();
+}
+
+size_t Receiver::processReady()
+{
+    return _impl->processReady();
+}
+
+void Receiver::start( const Executor& executor )
+{
+    _impl->start( executor );
+}
+
+void Receiver::stop()
+{
+    _impl->stop();
+}
+
+bool Receiver::isRunning() const
+{
+    return _impl->isRunning();
+}
+
+void Receiver::leaveGroup()
+{
+    _impl->remove( this );
+}
+
+const std::string& Receiver::getWakeupURI() const
+{
+    return _impl->getWakeupURI();
+}
+
+const Executor& Receiver::getExecutor() const
+{
+    return _impl->getExecutor();
+}
+
+bool Receiver::wait( void* socket, const uint32_t timeout )
+{
+    return _impl->wait( socket, timeout );
 }
 
 void* Receiver::getZMQContext()
@@ -26,6 +26,8 @@ namespace connection { namespace detail{ class Broker; }}
  * of multiple instances of receivers. Receivers form a shared group by linking
  * them at construction time.
  *
+ * Receiving can be delegated to a background thread using start() and stop().
+ *
  * Not intended to be as a final class. Not thread safe.
  *
  * Example: @include tests/receiver.cpp
@@ -43,6 +45,7 @@ public:
      * on any of them.
      *
      * @param shared another receiver to form a simultaneous receive group with.
+     * @throw std::runtime_error if the group receives in a thread, see start()
      */
     ZEQ_API explicit Receiver( Receiver& shared );
 
@@ -59,24 +62,97 @@ public:
      */
     ZEQ_API bool receive( const uint32_t timeout = TIMEOUT_INDEFINITE );
 
+    /**
+     * Receive and process all pending events from all shared receivers,
+     * within a budget.
+     *
+     * Waits like receive() for at least one event, then processes the events
+     * pending on all signalled sockets round-robin without polling again,
+     * until they are drained or the budget is spent. This saves a poll per
+     * event under load and bounds the time spent in event handlers, e.g., per
+     * rendered frame.
+     *
+     * @param timeout timeout in ms for poll, blocking until at least one event
+     *                is received if TIMEOUT_INDEFINITE
+     * @param maxEvents maximum number of events to process, 0 for no limit.
+     *                  The events conflated by a subscriber are processed
+     *                  together and may exceed it.
+     * @param maxTime maximum time in microseconds to spend processing events,
+     *                0 for no limit
+     * @return the number of processed events
+     * @throw std::runtime_error when polling failed.
+     */
+    ZEQ_API size_t drain( uint32_t timeout, size_t maxEvents,
+                          uint32_t maxTime = 0 );
+
+    /**
+     * @return the native descriptors of all shared receivers, to integrate
+     *         them into an external event loop.
+     *
+     * The descriptors become readable when data arrives or the receivers need
+     * an update, e.g., for a publisher found by zeroconf. They are edge
+     * triggered: call processReady() each time one of them is readable. The
+     * descriptors change when receivers join or leave the group.
+     */
+    ZEQ_API FileDescriptors getFileDescriptors();
+
+    /**
+     * Process all pending events of all shared receivers without blocking.
+     *
+     * @return the number of processed events
+     * @throw std::runtime_error when polling failed.
+     */
+    ZEQ_API size_t processReady();
+
+    /**
+     * Start receiving from all shared receivers in a background thread.
+     *
+     * The thread blocks in receive until data arrives and runs until stop().
+     * Event handlers are called from this thread, or handed as a task to the
+     * given executor, e.g., to queue them for the application's main loop.
+     *
+     * While running, receive() and drain() must not be called, handlers must
+     * not be (de)registered and no receiver may join the group. A receiver
+     * destroyed meanwhile leaves the group, the thread continues with the
+     * remaining ones.
+     *
+     * @param executor called from the receive thread with a task running the
+     *                 handler of each event, empty to call handlers directly
+     * @throw std::runtime_error if the group is already running
+     */
+    ZEQ_API void start( const Executor& executor = Executor( ));
+
+    /** Stop the thread started by start(), returns once it has exited. */
+    ZEQ_API void stop();
+
+    /** @return true if the group receives in a background thread. */
+    ZEQ_API bool isRunning() const;
+
 protected:
     friend class detail::Receiver;
 
-    /** Add this receiver's sockets to the given list */
+    /**
+     * Add this receiver's sockets to the given list.
+     *
+     * The poll set of a receive group is cached, this is only called again
+     * after receivers joined or left the group.
+     */
     virtual void addSockets( std::vector< detail::Socket >& entries ) = 0;
 
     /**
      * Process data on a signalled socket.
      *
      * @param socket the socket provided from addSockets().
+     * @return the number of events handled.
      */
-    virtual void process( detail::Socket& socket ) = 0;
+    virtual size_t process( detail::Socket& socket ) = 0;
 
     /**
      * Update the internal connection list.
      *
-     * Called on all members of a shared group regularly by receive() to update
-     * their list of sockets.
+     * Called on all members of a shared group by receive() before polling,
+     * and whenever a message is sent to getWakeupURI(), e.g., by a thread
+     * discovering new connections.
      */
     virtual void update() {}
 
@@ -90,6 +166,28 @@ protected:
 
     void* getZMQContext(); //!< @internal returns the ZeroMQ context
 
+    /**
+     * @internal Leave the receive group, stopping the thread of a running
+     * group meanwhile. Called by the destructor of derived classes, before the
+     * thread could call them while their members are destroyed.
+     */
+    void leaveGroup();
+
+    /** @internal @return the inproc address to wake up receive() for update */
+    const std::string& getWakeupURI() const;
+
+    /** @internal @return the executor for event handlers, see start() */
+    const Executor& getExecutor() const;
+
+    /**
+     * @internal Wait for data on the given socket of this receiver. Wakeups
+     * update all receivers of the group, as during receive().
+     *
+     * @return true if data is pending on the socket within timeout
+     * @throw std::runtime_error when polling failed.
+     */
+    bool wait( void* socket, uint32_t timeout );
+
 private:
     Receiver& operator=( const Receiver& ) = delete;
 
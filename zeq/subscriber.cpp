@@ -6,10 +6,17 @@
 
 #include "subscriber.h"
 
+#include "dispatcher.h"
 #include "event.h"
+#include "eventBatch.h"
 #include "log.h"
 #include "detail/broker.h"
+#include "detail/bufferPool.h"
+#include "detail/compression.h"
 #include "detail/constants.h"
+#include "detail/discovery.h"
+#include "detail/flatMap.h"
+#include "detail/smallVector.h"
 #include "detail/sender.h"
 #include "detail/socket.h"
 #include "detail/byteswap.h"
@@ -17,20 +24,45 @@
 #include <servus/serializable.h>
 #include <servus/servus.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <map>
+#include <mutex>
+#include <set>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace zeq
 {
+namespace
+{
+// Upper bound of messages drained from the publishers to conflate events
+const size_t MAX_CONFLATED = 1024;
+// Upper bound of messages received by one collect()
+const size_t MAX_COLLECTED = 65536;
+// Upper bound of events of collected types kept between collect() calls
+const size_t MAX_PENDING = 65536;
+}
+
 class Subscriber::Impl
 {
 public:
-    Impl( const std::string& session, void* context )
-        : _browser( PUBLISHER_SERVICE )
+    Impl( const std::string& session, void* context,
+          const std::string& wakeupURI )
+        : _socket( 0 )
+        , _lastToken( 0 )
+        , _removals( 0 )
+        , _dispatcher( nullptr )
         , _selfInstance( detail::Sender::getUUID( ))
+        , _replayID( servus::make_UUID( ))
         , _session( session == DEFAULT_SESSION ? getDefaultSession() : session )
+        , _decompressed( 0 )
+        , _compressedBytes( 0 )
+        , _decompressedBytes( 0 )
+        , _decompressionTime( 0 )
     {
         if( _session == zeq::NULL_SESSION || session.empty( ))
             ZEQTHROW( std::runtime_error( std::string(
@@ -40,31 +72,51 @@ public:
             ZEQTHROW( std::runtime_error(
                           std::string( "Empty servus implementation" )));
 
-        _browser.beginBrowsing( servus::Servus::IF_ALL );
-        update( context );
+        _socket = _createSocket( context );
+        _discovery.reset( new detail::Discovery( context, wakeupURI ));
     }
 
     Impl( const URI& uri, void* context )
-        : _browser( PUBLISHER_SERVICE )
+        : _socket( 0 )
+        , _lastToken( 0 )
+        , _removals( 0 )
+        , _dispatcher( nullptr )
         , _selfInstance( detail::Sender::getUUID( ))
+        , _replayID( servus::make_UUID( ))
+        , _decompressed( 0 )
+        , _compressedBytes( 0 )
+        , _decompressedBytes( 0 )
+        , _decompressionTime( 0 )
     {
         if( uri.getHost().empty() || uri.getPort() == 0 )
                 ZEQTHROW( std::runtime_error( std::string(
                               "Non-fully qualified URI used for subscriber" )));
 
+        _socket = _createSocket( context );
         const std::string& zmqURI = buildZmqURI( uri );
-        if( !addConnection( context, zmqURI, uint128_t( )))
+        if( !addConnection( zmqURI, uint128_t( )))
         {
+            const std::string error = zmq_strerror( zmq_errno( ));
+            zmq_close( _socket );
             ZEQTHROW( std::runtime_error(
                           "Cannot connect subscriber to " + zmqURI + ": " +
-                           zmq_strerror( zmq_errno( ))));
+                           error ));
         }
     }
 
-    Impl( const URI& uri, const std::string& session, void* context )
-        : _browser( PUBLISHER_SERVICE )
+    Impl( const URI& uri, const std::string& session, void* context,
+          const std::string& wakeupURI )
+        : _socket( 0 )
+        , _lastToken( 0 )
+        , _removals( 0 )
+        , _dispatcher( nullptr )
         , _selfInstance( detail::Sender::getUUID( ))
+        , _replayID( servus::make_UUID( ))
         , _session( session == DEFAULT_SESSION ? getDefaultSession() : session )
+        , _decompressed( 0 )
+        , _compressedBytes( 0 )
+        , _decompressedBytes( 0 )
+        , _decompressionTime( 0 )
     {
         if( _session == zeq::NULL_SESSION || session.empty( ))
             ZEQTHROW( std::runtime_error( std::string(
@@ -76,308 +128,803 @@ public:
                 ZEQTHROW( std::runtime_error(
                               std::string( "Empty servus implementation" )));
 
-            _browser.beginBrowsing( servus::Servus::IF_ALL );
-            update( context );
+            _socket = _createSocket( context );
+            _discovery.reset( new detail::Discovery( context, wakeupURI ));
         }
         else
         {
+            _socket = _createSocket( context );
             const std::string& zmqURI = buildZmqURI( uri );
-            if( !addConnection( context, zmqURI, uint128_t( )))
+            if( !addConnection( zmqURI, uint128_t( )))
             {
+                const std::string error = zmq_strerror( zmq_errno( ));
+                zmq_close( _socket );
                 ZEQTHROW( std::runtime_error(
                               "Cannot connect subscriber to " + zmqURI + ": " +
-                               zmq_strerror( zmq_errno( ))));
+                               error ));
             }
         }
     }
 
     ~Impl()
     {
-        for( const auto& socket : _subscribers )
+        // updates still queued on a dispatcher or executor skip the objects
+        _targets.forEach( []( const uint128_t&, const Target& target )
         {
-            if( socket.second )
-                zmq_close( socket.second );
-        }
-        if( _browser.isBrowsing( ))
-            _browser.endBrowsing();
+            if( target.serializable )
+                _invalidate( *target.serializable );
+        });
+
+        _discovery.reset(); // closes its socket before the context
+        zmq_close( _socket );
     }
 
-    bool registerHandler( const uint128_t& event, const EventFunc& func )
+    bool registerHandler( const uint128_t& event, const EventFunc& func,
+                          const Delivery delivery )
     {
-        if( _eventFuncs.count( event ) != 0 )
+        const Target* existing = _targets.find( event );
+        if( existing && !existing->handlers.empty( ))
             return false;
 
-        // Add subscription to existing sockets
-        for( const auto& socket : _subscribers )
+        return addHandler( event, func, delivery ) != 0;
+    }
+
+    bool deregisterHandler( const uint128_t& event )
+    {
+        Target* target = _targets.find( event );
+        if( !target || target->handlers.empty( ))
+            return false;
+
+        for( const Handler& handler : target->handlers )
         {
-            if( socket.second &&
-                zmq_setsockopt( socket.second, ZMQ_SUBSCRIBE,
-                                &event, sizeof( event )) == -1 )
-            {
-                ZEQTHROW( std::runtime_error(
-                    std::string( "Cannot update topic filter: " ) +
-                    zmq_strerror( zmq_errno( ))));
-            }
+            _tokens.erase( handler.token );
+            _unsubscribe( event );
         }
-
-        _eventFuncs[event] = func;
+        target->handlers.clear();
+        ++_removals;
+        if( target->isUnused( ))
+            _targets.erase( event );
         return true;
     }
 
-    bool deregisterHandler( const uint128_t& event )
+    bool hasHandler( const uint128_t& event ) const
     {
-        if( _eventFuncs.erase( event ) == 0 )
+        const Target* target = _targets.find( event );
+        return target && !target->handlers.empty();
+    }
+
+    HandlerToken addHandler( const uint128_t& event, const EventFunc& func,
+                             const Delivery delivery )
+    {
+        if( !_hasDelivery( event, delivery ))
+            return 0;
+
+        _subscribe( event );
+        const Handler handler = { ++_lastToken, func };
+        Target& target = _targets[ event ];
+        target.handlers.push_back( handler );
+        target.conflate = delivery == DELIVER_LATEST;
+        _tokens[ handler.token ] = event;
+        return handler.token;
+    }
+
+    bool removeHandler( const HandlerToken token )
+    {
+        const auto i = _tokens.find( token );
+        if( i == _tokens.end( ))
             return false;
 
-        for( const auto& socket : _subscribers )
+        const uint128_t event = i->second;
+        _tokens.erase( i );
+        ++_removals;
+
+        Target* target = _targets.find( event );
+        assert( target );
+        Handlers& handlers = target->handlers;
+        for( Handlers::iterator j = handlers.begin(); j != handlers.end(); ++j )
         {
-            if( socket.second &&
-                zmq_setsockopt( socket.second, ZMQ_UNSUBSCRIBE,
-                                &event, sizeof( event )) == -1 )
+            if( j->token == token )
             {
-                ZEQTHROW( std::runtime_error(
-                    std::string( "Cannot update topic filter: " ) +
-                    zmq_strerror( zmq_errno( ))));
+                handlers.erase( j );
+                break;
             }
         }
-
+        if( target->isUnused( ))
+            _targets.erase( event );
+        _unsubscribe( event );
         return true;
     }
 
-    bool hasHandler( const uint128_t& event ) const
+    bool subscribe( servus::Serializable& serializable,
+                    const Delivery delivery )
     {
-        return _eventFuncs.count( event ) > 0;
+        const uint128_t& type = serializable.getTypeIdentifier();
+        const Target* existing = _targets.find( type );
+        if( existing && existing->serializable )
+            return false;
+        if( !_hasDelivery( type, delivery ))
+            return false;
+
+        _subscribe( type );
+        Target& target = _targets[ type ];
+        target.serializable.reset( new SerializableRef( serializable ));
+        target.conflate = delivery == DELIVER_LATEST;
+        return true;
     }
 
-    bool subscribe( servus::Serializable& serializable )
+    bool unsubscribe( const servus::Serializable& serializable )
     {
         const uint128_t& type = serializable.getTypeIdentifier();
-        if( _serializables.count( type ) != 0 )
+        Target* target = _targets.find( type );
+        if( !target || !target->serializable )
+            return false;
+
+        _invalidate( *target->serializable );
+        target->serializable.reset();
+        if( target->isUnused( ))
+            _targets.erase( type );
+        _unsubscribe( type );
+        return true;
+    }
+
+    bool subscribe( const uint128_t& type )
+    {
+        const Target* existing = _targets.find( type );
+        if( existing && existing->collect )
             return false;
 
         _subscribe( type );
-        _serializables[ type ] = &serializable;
+        _targets[ type ].collect = true;
         return true;
     }
 
-    bool unsubscribe( const servus::Serializable& serializable )
+    bool unsubscribe( const uint128_t& type )
     {
-        const uint128_t& type = serializable.getTypeIdentifier();
-        if( _serializables.erase( type ) == 0 )
+        Target* target = _targets.find( type );
+        if( !target || !target->collect )
             return false;
 
+        target->collect = false;
+        if( target->isUnused( ))
+            _targets.erase( type );
         _unsubscribe( type );
+
+        // drop the events not collected yet
+        if( !_pending.empty( ))
+        {
+            EventBatch pending;
+            _takePending( pending, &type );
+        }
         return true;
     }
 
+    /** Move the pending events and receive without blocking */
+    size_t collect( EventBatch& batch, const uint128_t* type,
+                    const Executor& executor )
+    {
+        update();
+
+        const size_t size = batch.size();
+        _takePending( batch, type );
+
+        // Bounded to not starve on fast publishers
+        for( size_t i = 0; i < MAX_COLLECTED; ++i )
+        {
+            Message message;
+            if( !_receive( _socket, message, ZMQ_DONTWAIT ))
+                break;
+
+            const bool wanted = !type || message.type == *type;
+            _dispatch( message, _targets.find( message.type ), executor,
+                       wanted ? batch : _pending );
+        }
+        return batch.size() - size;
+    }
+
+    void* getSocket() { return _socket; }
+
     void addSockets( std::vector< detail::Socket >& entries )
     {
-        entries.insert( entries.end(), _entries.begin(), _entries.end( ));
+        detail::Socket entry;
+        entry.socket = _socket;
+        entry.events = ZMQ_POLLIN;
+        entries.push_back( entry );
     }
 
-    void process( detail::Socket& socket )
+    /** @return the number of dispatched events */
+    size_t process( detail::Socket& socket, const Executor& executor )
     {
-        zmq_msg_t msg;
-        zmq_msg_init( &msg );
-        zmq_msg_recv( &msg, socket.socket, 0 );
+        Message message;
+        if( !_receive( socket.socket, message, 0 ))
+            return 0;
 
-        uint128_t type;
-        memcpy( &type, zmq_msg_data( &msg ), sizeof(type) );
-#ifndef COMMON_LITTLEENDIAN
-        detail::byteswap( type ); // convert from little endian wire
-#endif
-        const bool payload = zmq_msg_more( &msg );
-        zmq_msg_close( &msg );
+        const Target* target = _targets.find( message.type );
+        if( !target || !target->conflate )
+        {
+            _dispatch( message, target, executor );
+            return 1;
+        }
 
-        SerializableMap::const_iterator i = _serializables.find( type );
-        if( i == _serializables.end( )) // FlatBuffer
+        // Drain the pending messages, keeping only the newest one of each
+        // conflated type from all publishers. Bounded to not starve on fast
+        // publishers.
+        size_t dispatched = 0;
+        _conflate( message );
+        for( size_t i = 0; i < MAX_CONFLATED; ++i )
         {
-            zeq::Event event( type );
-            if( payload )
-            {
-                zmq_msg_init( &msg );
-                zmq_msg_recv( &msg, socket.socket, 0 );
-                const size_t size = zmq_msg_size( &msg );
-                ConstByteArray data( new uint8_t[size],
-                                     std::default_delete< uint8_t[] >( ));
-                memcpy( (void*)data.get(), zmq_msg_data( &msg ), size );
-                event.setData( data, size );
-                assert( event.getSize() == size );
-                zmq_msg_close( &msg );
-            }
+            if( !_receive( socket.socket, message, ZMQ_DONTWAIT ))
+                break;
 
-            if( _eventFuncs.count( type ) != 0 )
-                _eventFuncs[type]( event );
-#ifndef NDEBUG
+            target = _targets.find( message.type );
+            if( target && target->conflate )
+                _conflate( message );
             else
             {
-                // Note eile: The topic filtering in the handler registration
-                // should ensure that we don't get messages we haven't
-                // handlers. If this throws, something does not work.
-                ZEQTHROW( std::runtime_error( "Got unsubscribed event" ));
+                _dispatch( message, target, executor );
+                ++dispatched;
             }
-#endif
         }
-        else // serializable
+
+        // handlers may call receive() again, which conflates anew
+        std::vector< Conflated* > latest;
+        latest.swap( _latest );
+        for( Conflated* conflated : latest )
         {
-            servus::Serializable* serializable = i->second;
-            if( payload )
-            {
-                zmq_msg_init( &msg );
-                zmq_msg_recv( &msg, socket.socket, 0 );
-                serializable->fromBinary( zmq_msg_data( &msg ),
-                                          zmq_msg_size( &msg ));
-                zmq_msg_close( &msg );
-            }
-            serializable->notifyUpdated();
+            message.take( conflated->message );
+            conflated->pending = false;
+            _dispatch( message, _targets.find( message.type ), executor );
         }
+        dispatched += latest.size();
+
+        latest.clear();
+        if( _latest.empty( ))
+            _latest.swap( latest ); // keep the capacity
+        return dispatched;
     }
 
-    void update( void* context )
+    void update()
     {
-        if( _browser.isBrowsing( ))
-            _browser.browse( 0 );
-        const servus::Strings& instances = _browser.getInstances();
-        for( const std::string& instance : instances )
+        if( !_discovery )
+            return;
+
+        // Publishers which left zeroconf may come back with a new address
+        for( const std::string& uri : _discovery->takeRemoved( ))
         {
-            const std::string& zmqURI = _getZmqURI( instance );
+            if( _publishers.erase( uri ) == 0 )
+                continue;
+            zmq_disconnect( _socket, uri.c_str( ));
+            ZEQINFO << "Unsubscribed from " << uri << std::endl;
+        }
 
+        const detail::Discovery::Publishers& publishers =
+            _discovery->takePublishers();
+        for( const detail::Discovery::Publisher& publisher : publishers )
+        {
             // New subscription
-            if( _subscribers.count( zmqURI ) == 0 )
+            if( _publishers.count( publisher.uri ) != 0 )
+                continue;
+
+            if( publisher.hasSession && !_session.empty() &&
+                publisher.session != _session )
             {
-                const std::string& session = _browser.get( instance,
-                                                           KEY_SESSION );
-                if( _browser.containsKey( instance, KEY_SESSION ) &&
-                    !_session.empty() && session != _session )
-                {
-                    continue;
-                }
+                continue;
+            }
 
-                const uint128_t identifier( _browser.get( instance,
-                                                          KEY_INSTANCE ));
-                if( !addConnection( context, zmqURI, identifier ))
-                {
-                    ZEQINFO << "Cannot connect subscriber to " << zmqURI << ": "
-                            << zmq_strerror( zmq_errno( )) << std::endl;
-                }
+            if( !addConnection( publisher.uri, publisher.instance ))
+            {
+                ZEQINFO << "Cannot connect subscriber to " << publisher.uri
+                        << ": " << zmq_strerror( zmq_errno( )) << std::endl;
             }
         }
     }
 
-    bool addConnection( void* context, const std::string& zmqURI,
-                        const uint128_t& instance )
+    bool addConnection( const std::string& zmqURI, const uint128_t& instance )
     {
         if( instance == _selfInstance )
             return true;
 
-        _subscribers[zmqURI] = zmq_socket( context, ZMQ_SUB );
+        // The socket sends its subscriptions to the new publisher. Failed
+        // connections are remembered as well, unconnectable peer.
+        _publishers.insert( zmqURI );
+        if( zmq_connect( _socket, zmqURI.c_str( )) == -1 )
+            return false;
+
+        ZEQINFO << "Subscribed to " << zmqURI << std::endl;
+        return true;
+    }
+
+    const std::string& getSession() const { return _session; }
+
+    void setDispatcher( Dispatcher* dispatcher ) { _dispatcher = dispatcher; }
+
+    Stats getStats() const
+    {
+        Stats stats;
+        stats.decompressed = _decompressed;
+        stats.compressedBytes = _compressedBytes;
+        stats.decompressedBytes = _decompressedBytes;
+        stats.decompressionTime = _decompressionTime;
+        return stats;
+    }
+
+private:
+    // One socket connected to all publishers, a receive polls it only once
+    // independent of the number of publishers.
+    void* _socket;
+    std::set< std::string > _publishers; // zmq URIs of the connections
+
+    struct Handler
+    {
+        HandlerToken token;
+        EventFunc func;
+    };
+    // most types have one or two handlers, stored without allocation
+    typedef detail::SmallVector< Handler, 2 > Handlers;
+
+    /**
+     * A subscribed serializable object, shared with its updates posted to a
+     * dispatcher or executor. Unsubscribing resets the object once a running
+     * update has finished, and the updates still queued skip it.
+     */
+    struct SerializableRef
+    {
+        explicit SerializableRef( servus::Serializable& object_ )
+            : object( &object_ ) {}
+
+        std::recursive_mutex mutex; // held by updates, which may unsubscribe
+        servus::Serializable* object; // nullptr once unsubscribed
+    };
+    typedef std::shared_ptr< SerializableRef > SerializablePtr;
+
+    /**
+     * Receiver of an event type: handlers, a serializable object and/or
+     * collect()
+     */
+    struct Target
+    {
+        Target() : conflate( false ), collect( false ) {}
+
+        bool isUnused() const
+            { return handlers.empty() && !serializable && !collect; }
+
+        Handlers handlers;
+        SerializablePtr serializable;
+        bool conflate; // DELIVER_LATEST
+        bool collect; // subscribe( type )
+    };
+
+    // Resolves the type of each received message with one probe
+    detail::FlatMap< Target > _targets;
+    std::unordered_map< HandlerToken, uint128_t > _tokens;
+    HandlerToken _lastToken;
+    uint64_t _removals; // of handlers, to detect removals during dispatch
+
+    Dispatcher* _dispatcher;
+
+    // events of collected types received outside of collect()
+    EventBatch _pending;
+
+    // publishers found on zeroconf, wakes up receive() for update()
+    std::unique_ptr< detail::Discovery > _discovery;
+
+    const uint128_t _selfInstance;
+    const uint128_t _replayID; // prefix of the replay topics, see _subscribe()
+    const std::string _session;
+
+    // read by getStats() from any thread
+    std::atomic< uint64_t > _decompressed;
+    std::atomic< uint64_t > _compressedBytes;
+    std::atomic< uint64_t > _decompressedBytes;
+    std::atomic< uint64_t > _decompressionTime;
+
+    /** A received event, owning the ZeroMQ message with its payload */
+    struct Message
+    {
+        Message() : offset( 0 ) { zmq_msg_init( &msg ); }
+        ~Message() { zmq_msg_close( &msg ); }
+
+        /** Replace this message by the given one, dropping the old payload */
+        void take( Message& other )
+        {
+            type = other.type;
+            offset = other.offset;
+            zmq_msg_move( &msg, &other.msg );
+        }
+
+        /** Copy the payload to a pooled buffer and release the message */
+        void detach()
+        {
+            const size_t size = zmq_msg_size( &msg ) - offset;
+            std::shared_ptr< uint8_t > buffer =
+                detail::BufferPool::getInstance().allocate( size );
+            ::memcpy( buffer.get(), static_cast< const uint8_t* >(
+                          zmq_msg_data( &msg )) + offset, size );
+            zmq_msg_close( &msg );
+            zmq_msg_init_data( &msg, buffer.get(), size, _releaseBuffer,
+                               new std::shared_ptr< uint8_t >( buffer ));
+            offset = 0;
+        }
+
+        uint128_t type;
+        zmq_msg_t msg;
+        size_t offset; // of the payload in msg
+
+    private:
+        Message( const Message& ) = delete;
+        Message& operator=( const Message& ) = delete;
+    };
+
+    /** The newest message of a conflated type, reused by process() */
+    struct Conflated
+    {
+        Conflated() : pending( false ) {}
+
+        Message message;
+        bool pending; // in _latest
+    };
+    std::unordered_map< uint128_t, Conflated > _conflated;
+    std::vector< Conflated* > _latest; // pending ones in arrival order
+
+    void _conflate( Message& message )
+    {
+        Conflated& conflated = _conflated[ message.type ];
+        conflated.message.take( message );
+        if( conflated.pending )
+            return;
+        conflated.pending = true;
+        _latest.push_back( &conflated );
+    }
+
+    bool _receive( void* socket, Message& message, int flags )
+    {
+        // drop malformed or undecodable events, try the next one
+        while( zmq_msg_recv( &message.msg, socket, flags ) != -1 )
+        {
+            if( _parse( socket, message ))
+                return true;
+            flags = ZMQ_DONTWAIT;
+        }
+        return false;
+    }
 
-        if( zmq_connect( _subscribers[zmqURI], zmqURI.c_str( )) == -1 )
+    /** Complete the received header frame, @return false to drop it */
+    bool _parse( void* socket, Message& message )
+    {
+        if( zmq_msg_size( &message.msg ) < sizeof( message.type ))
         {
-            zmq_close( _subscribers[zmqURI] );
-            _subscribers[zmqURI] = 0; // keep empty entry, unconnectable peer
+            ZEQWARN << "Dropping malformed event of "
+                    << zmq_msg_size( &message.msg ) << " bytes" << std::endl;
+            _skipFrames( socket, message );
             return false;
         }
 
-        // Add existing subscriptions to socket
-        for( const auto& i : _eventFuncs )
+        const uint8_t* header =
+            static_cast< const uint8_t* >( zmq_msg_data( &message.msg ));
+        memcpy( &message.type, header, sizeof( message.type ));
+#ifndef COMMON_LITTLEENDIAN
+        detail::byteswap( message.type ); // convert from little endian wire
+#endif
+        message.offset = sizeof( message.type );
+
+        // A last value replayed to us has the type after our replay ID
+        if( message.type == _replayID )
         {
-            if( zmq_setsockopt( _subscribers[zmqURI], ZMQ_SUBSCRIBE,
-                                &i.first, sizeof( uint128_t )) == -1 )
+            if( zmq_msg_size( &message.msg ) < REPLAY_TOPIC_SIZE )
             {
-                ZEQTHROW( std::runtime_error(
-                    std::string( "Cannot update topic filter: " ) +
-                    zmq_strerror( zmq_errno( ))));
+                ZEQWARN << "Dropping malformed replayed event of "
+                        << zmq_msg_size( &message.msg ) << " bytes"
+                        << std::endl;
+                _skipFrames( socket, message );
+                return false;
             }
+            memcpy( &message.type, header + sizeof( message.type ),
+                    sizeof( message.type ));
+#ifndef COMMON_LITTLEENDIAN
+            detail::byteswap( message.type );
+#endif
+            message.offset = REPLAY_TOPIC_SIZE;
         }
-        for( const auto& i : _serializables )
+
+        // The payload is either in a second frame (FORMAT_TWO_FRAMES) or
+        // follows the type in the same frame (FORMAT_SINGLE_FRAME).
+        if( !zmq_msg_more( &message.msg ))
+            return true;
+
+        // Compressed payloads have their codec and size in the header frame
+        uint32_t codec = COMPRESSION_NONE;
+        uint64_t size = 0;
+        if( zmq_msg_size( &message.msg ) >= message.offset + sizeof( codec ) +
+                                            sizeof( size ))
         {
-            if( zmq_setsockopt( _subscribers[zmqURI], ZMQ_SUBSCRIBE,
-                                &i.first, sizeof( uint128_t )) == -1 )
-            {
-                ZEQTHROW( std::runtime_error(
-                    std::string( "Cannot update topic filter: " ) +
-                    zmq_strerror( zmq_errno( ))));
-            }
+            header += message.offset;
+            memcpy( &codec, header, sizeof( codec ));
+            memcpy( &size, header + sizeof( codec ), sizeof( size ));
+#ifndef COMMON_LITTLEENDIAN
+            detail::byteswap( codec );
+            detail::byteswap( size );
+#endif
+        }
+
+        zmq_msg_close( &message.msg );
+        zmq_msg_init( &message.msg );
+        zmq_msg_recv( &message.msg, socket, 0 );
+        message.offset = 0;
+
+        if( codec == COMPRESSION_NONE ||
+            _decompress( message, Compression( codec ), size ))
+        {
+            return true;
         }
 
-        assert( _subscribers.find( zmqURI ) != _subscribers.end( ));
-        if( _subscribers.find( zmqURI ) == _subscribers.end( ))
+        ZEQWARN << "Dropping event " << message.type << ", cannot decompress "
+                << "payload with codec " << codec << std::endl;
+        return false;
+    }
+
+    /** Drop the remaining frames of a multi-part message */
+    void _skipFrames( void* socket, Message& message )
+    {
+        while( zmq_msg_more( &message.msg ))
+        {
+            zmq_msg_close( &message.msg );
+            zmq_msg_init( &message.msg );
+            zmq_msg_recv( &message.msg, socket, 0 );
+        }
+    }
+
+    /** Replace the compressed payload of the message by a pooled buffer */
+    bool _decompress( Message& message, const Compression compression,
+                      const uint64_t size )
+    {
+        const size_t compressedSize = zmq_msg_size( &message.msg );
+        if( size == 0 || size != uint64_t( size_t( size )) ||
+            !detail::isAvailable( compression ) ||
+            size / detail::MAX_COMPRESSION_RATIO > compressedSize )
+        {
             return false;
+        }
 
-        detail::Socket entry;
-        entry.socket = _subscribers[zmqURI];
-        entry.events = ZMQ_POLLIN;
-        _entries.push_back( entry );
-        ZEQINFO << "Subscribed to " << zmqURI << std::endl;
+        const auto start = std::chrono::steady_clock::now();
+        std::shared_ptr< uint8_t > buffer =
+            detail::BufferPool::getInstance().allocate( size );
+        if( !detail::decompress( compression, zmq_msg_data( &message.msg ),
+                                 compressedSize, buffer.get(), size ))
+        {
+            return false;
+        }
+
+        // The message keeps the buffer until the event releases it
+        zmq_msg_close( &message.msg );
+        zmq_msg_init_data( &message.msg, buffer.get(), size, _releaseBuffer,
+                           new std::shared_ptr< uint8_t >( buffer ));
+
+        ++_decompressed;
+        _compressedBytes += compressedSize;
+        _decompressedBytes += size;
+        _decompressionTime +=
+            std::chrono::duration_cast< std::chrono::microseconds >(
+                std::chrono::steady_clock::now() - start ).count();
         return true;
     }
 
-    const std::string& getSession() const { return _session; }
+    static void _releaseBuffer( void*, void* hint )
+    {
+        delete static_cast< std::shared_ptr< uint8_t >* >( hint );
+    }
 
-private:
-    typedef std::map< uint128_t, EventFunc > EventFuncs;
-    typedef std::map< std::string, void* > SocketMap;
+    void _dispatch( Message& message, const Target* target,
+                    const Executor& executor )
+    {
+        _dispatch( message, target, executor, _pending );
+    }
 
-    SocketMap _subscribers;
-    EventFuncs _eventFuncs;
+    void _dispatch( Message& message, const Target* target,
+                    const Executor& executor, EventBatch& collected )
+    {
+        const uint128_t& type = message.type;
+        if( !target )
+        {
+#ifndef NDEBUG
+            // Note eile: The topic filtering in the handler registration
+            // should ensure that we don't get messages we haven't
+            // handlers. If this throws, something does not work.
+            ZEQTHROW( std::runtime_error( "Got unsubscribed event" ));
+#endif
+            return;
+        }
 
-    typedef std::map< uint128_t, servus::Serializable* > SerializableMap;
-    SerializableMap _serializables;
+        if( target->collect )
+        {
+            // drop the newest events if collect() is not called
+            if( &collected != &_pending || _pending.size() < MAX_PENDING )
+            {
+                collected.add( type, static_cast< const uint8_t* >(
+                                   zmq_msg_data( &message.msg )) +
+                                   message.offset,
+                               zmq_msg_size( &message.msg ) - message.offset );
+            }
+            if( target->handlers.empty() && !target->serializable )
+                return;
+        }
 
-    servus::Servus _browser;
-    std::vector< detail::Socket > _entries;
+        if( !target->serializable ) // FlatBuffer
+        {
+            const size_t size = zmq_msg_size( &message.msg ) - message.offset;
+            zeq::Event event( type );
+            // the event takes over the message, handlers read straight from
+            // ZeroMQ's receive buffer
+            if( size > 0 )
+                event.setData( message.msg, message.offset );
+
+            // Handlers may add or remove handlers, which moves the targets
+            // and their handlers. Call a copy of the handlers instead.
+            Handlers handlers;
+            for( const Handler& handler : target->handlers )
+                handlers.push_back( handler );
+            target = nullptr;
+
+            if( _dispatcher || executor )
+            {
+                // the handlers run later, don't pin ZeroMQ's receive buffer
+                event.detach();
+                std::shared_ptr< zeq::Event > shared(
+                    new zeq::Event( std::move( event )));
+                for( const Handler& handler : handlers )
+                {
+                    const EventFunc& func = handler.func;
+                    _post( type, [func, shared] { func( *shared ); },
+                           executor );
+                }
+            }
+            else
+            {
+                // all handlers share the event, skip the ones removed by a
+                // previous handler
+                const uint64_t removals = _removals;
+                for( const Handler& handler : handlers )
+                {
+                    if( _removals == removals ||
+                        _tokens.count( handler.token ) > 0 )
+                    {
+                        handler.func( event );
+                    }
+                }
+            }
+        }
+        else if( _dispatcher || executor ) // serializable, updated later
+        {
+            const SerializablePtr serializable = target->serializable;
+            std::shared_ptr< Message > shared( new Message );
+            shared->take( message );
+            shared->detach();
+            _post( type, [serializable, shared]
+                {
+                    std::lock_guard< std::recursive_mutex > lock(
+                        serializable->mutex );
+                    if( serializable->object )
+                        _update( *serializable->object, *shared );
+                }, executor );
+        }
+        else // serializable
+            _update( *target->serializable->object, message );
+    }
 
-    const uint128_t _selfInstance;
-    const std::string _session;
+    /**
+     * @return true if the handlers and serializable of the given type, if any,
+     *         use the given delivery mode
+     */
+    bool _hasDelivery( const uint128_t& type, const Delivery delivery ) const
+    {
+        const Target* target = _targets.find( type );
+        if( !target || ( target->handlers.empty() && !target->serializable ))
+            return true;
+        return target->conflate == ( delivery == DELIVER_LATEST );
+    }
 
-    std::string _getZmqURI( const std::string& instance )
+    /** Move the pending events of the given type, or all, to the batch */
+    void _takePending( EventBatch& batch, const uint128_t* type )
     {
-        const size_t pos = instance.find( ":" );
-        const std::string& host = instance.substr( 0, pos );
-        const std::string& port = instance.substr( pos + 1 );
+        if( _pending.empty( ))
+            return;
 
-        return buildZmqURI( DEFAULT_SCHEMA, host, std::stoi( port ));
+        if( !type )
+        {
+            if( batch.empty( ))
+            {
+                std::swap( batch, _pending ); // moves, keeps both buffers
+            }
+            else
+            {
+                batch.add( _pending );
+                _pending.clear();
+            }
+            return;
+        }
+
+        batch.take( _pending, *type );
     }
 
+    void _post( const uint128_t& type, const Task& task,
+                const Executor& executor )
+    {
+        if( _dispatcher )
+            _dispatcher->post( type, task );
+        else
+            executor( task );
+    }
+
+    static void _update( servus::Serializable& serializable,
+                         Message& message )
+    {
+        const size_t size = zmq_msg_size( &message.msg ) - message.offset;
+        if( size > 0 )
+            serializable.fromBinary(
+                static_cast< const uint8_t* >(
+                    zmq_msg_data( &message.msg )) + message.offset, size );
+        serializable.notifyUpdated();
+    }
+
+    static void _invalidate( SerializableRef& serializable )
+    {
+        std::lock_guard< std::recursive_mutex > lock( serializable.mutex );
+        serializable.object = nullptr;
+    }
+
+    static void* _createSocket( void* context )
+    {
+        void* socket = zmq_socket( context, ZMQ_SUB );
+        if( !socket )
+        {
+            ZEQTHROW( std::runtime_error(
+                          std::string( "Cannot create subscriber socket: " ) +
+                          zmq_strerror( zmq_errno( ))));
+        }
+        return socket;
+    }
+
+    /**
+     * Subscribe to the event type and to its replay topic, which asks
+     * publishers with a last-value cache to send the current value to this
+     * subscriber only.
+     */
     void _subscribe( const uint128_t& event )
     {
-        for( const auto& socket : _subscribers )
+        const uint128_t replayTopic[2] = { _replayID, event };
+        if( zmq_setsockopt( _socket, ZMQ_SUBSCRIBE,
+                            &event, sizeof( event )) == -1 ||
+            zmq_setsockopt( _socket, ZMQ_SUBSCRIBE,
+                            replayTopic, sizeof( replayTopic )) == -1 )
         {
-            if( zmq_setsockopt( socket.second, ZMQ_SUBSCRIBE,
-                                &event, sizeof( event )) == -1 )
-            {
-                ZEQTHROW( std::runtime_error(
-                    std::string( "Cannot update topic filter: " ) +
-                    zmq_strerror( zmq_errno( ))));
-            }
+            ZEQTHROW( std::runtime_error(
+                std::string( "Cannot update topic filter: " ) +
+                zmq_strerror( zmq_errno( ))));
         }
     }
 
     void _unsubscribe( const uint128_t& event )
     {
-        for( const auto& socket : _subscribers )
+        const uint128_t replayTopic[2] = { _replayID, event };
+        if( zmq_setsockopt( _socket, ZMQ_UNSUBSCRIBE,
+                            &event, sizeof( event )) == -1 ||
+            zmq_setsockopt( _socket, ZMQ_UNSUBSCRIBE,
+                            replayTopic, sizeof( replayTopic )) == -1 )
         {
-            if( zmq_setsockopt( socket.second, ZMQ_UNSUBSCRIBE,
-                                &event, sizeof( event )) == -1 )
-            {
-                ZEQTHROW( std::runtime_error(
-                    std::string( "Cannot update topic filter: " ) +
-                    zmq_strerror( zmq_errno( ))));
-            }
+            ZEQTHROW( std::runtime_error(
+                std::string( "Cannot update topic filter: " ) +
+                zmq_strerror( zmq_errno( ))));
         }
     }
 };
 
 Subscriber::Subscriber()
     : Receiver()
-    , _impl( new Impl( DEFAULT_SESSION, getZMQContext( )))
+    , _impl( new Impl( DEFAULT_SESSION, getZMQContext(), getWakeupURI( )))
 {
 }
 
 Subscriber::Subscriber( const std::string& session )
     : Receiver()
-    , _impl( new Impl( session, getZMQContext( )))
+    , _impl( new Impl( session, getZMQContext(), getWakeupURI( )))
 {
 }
 
@@ -389,19 +936,19 @@ Subscriber::Subscriber( const URI& uri )
 
 Subscriber::Subscriber( const URI& uri, const std::string& session )
     : Receiver()
-    , _impl( new Impl( uri, session, getZMQContext( )))
+    , _impl( new Impl( uri, session, getZMQContext(), getWakeupURI( )))
 {
 }
 
 Subscriber::Subscriber( Receiver& shared )
     : Receiver( shared )
-    , _impl( new Impl( DEFAULT_SESSION, getZMQContext( )))
+    , _impl( new Impl( DEFAULT_SESSION, getZMQContext(), getWakeupURI( )))
 {
 }
 
 Subscriber::Subscriber( const std::string& session, Receiver& shared )
     : Receiver( shared )
-    , _impl( new Impl( session, getZMQContext( )))
+    , _impl( new Impl( session, getZMQContext(), getWakeupURI( )))
 {
 }
 
@@ -413,14 +960,14 @@ Subscriber::Subscriber( const URI& uri, Receiver& shared  )
 
 Subscriber::Subscriber( const URI& uri, const std::string& session, Receiver& shared  )
     : Receiver( shared )
-    , _impl( new Impl( uri, session, getZMQContext( )))
+    , _impl( new Impl( uri, session, getZMQContext(), getWakeupURI( )))
 {
 }
 
 Subscriber::Subscriber( const servus::URI& uri )
     : Receiver()
     , _impl( new Impl( URI( uri ), DEFAULT_SESSION,
-                                     getZMQContext( )))
+                                     getZMQContext(), getWakeupURI( )))
 {
     ZEQWARN << "zeq::Subscriber( const servus::URI& ) is deprecated"
             << std::endl;
@@ -429,7 +976,7 @@ Subscriber::Subscriber( const servus::URI& uri )
 Subscriber::Subscriber( const servus::URI& uri, Receiver& shared )
     : Receiver( shared )
     , _impl( new Impl( URI( uri ), DEFAULT_SESSION,
-                                     getZMQContext( )))
+                                     getZMQContext(), getWakeupURI( )))
 {
     ZEQWARN << "zeq::Subscriber( const servus::URI&, Receiver& shared ) is "
                "deprecated" << std::endl;
@@ -437,11 +984,13 @@ Subscriber::Subscriber( const servus::URI& uri, Receiver& shared )
 
 Subscriber::~Subscriber()
 {
+    leaveGroup();
 }
 
-bool Subscriber::registerHandler( const uint128_t& event, const EventFunc& func)
+bool Subscriber::registerHandler( const uint128_t& event, const EventFunc& func,
+                                  const Delivery delivery )
 {
-    return _impl->registerHandler( event, func );
+    return _impl->registerHandler( event, func, delivery );
 }
 
 bool Subscriber::deregisterHandler( const uint128_t& event )
@@ -454,9 +1003,22 @@ bool Subscriber::hasHandler( const uint128_t& event ) const
     return _impl->hasHandler( event );
 }
 
-bool Subscriber::subscribe( servus::Serializable& serializable )
+HandlerToken Subscriber::addHandler( const uint128_t& event,
+                                     const EventFunc& func,
+                                     const Delivery delivery )
+{
+    return _impl->addHandler( event, func, delivery );
+}
+
+bool Subscriber::removeHandler( const HandlerToken token )
 {
-    return _impl->subscribe( serializable );
+    return _impl->removeHandler( token );
+}
+
+bool Subscriber::subscribe( servus::Serializable& serializable,
+                            const Delivery delivery )
+{
+    return _impl->subscribe( serializable, delivery );
 }
 
 bool Subscriber::unsubscribe( const servus::Serializable& serializable )
@@ -464,29 +1026,69 @@ bool Subscriber::unsubscribe( const servus::Serializable& serializable )
     return _impl->unsubscribe( serializable );
 }
 
+bool Subscriber::subscribe( const uint128_t& type )
+{
+    return _impl->subscribe( type );
+}
+
+bool Subscriber::unsubscribe( const uint128_t& type )
+{
+    return _impl->unsubscribe( type );
+}
+
+size_t Subscriber::collect( EventBatch& batch, const uint32_t timeout )
+{
+    return _collect( batch, nullptr, timeout );
+}
+
+size_t Subscriber::collect( EventBatch& batch, const uint128_t& type,
+                            const uint32_t timeout )
+{
+    return _collect( batch, &type, timeout );
+}
+
+size_t Subscriber::_collect( EventBatch& batch, const uint128_t* type,
+                             const uint32_t timeout )
+{
+    const size_t collected = _impl->collect( batch, type, getExecutor( ));
+    if( collected > 0 || timeout == 0 || !wait( _impl->getSocket(), timeout ))
+        return collected;
+    return _impl->collect( batch, type, getExecutor( ));
+}
+
 const std::string& Subscriber::getSession() const
 {
     return _impl->getSession();
 }
 
+void Subscriber::setDispatcher( Dispatcher* dispatcher )
+{
+    _impl->setDispatcher( dispatcher );
+}
+
+Subscriber::Stats Subscriber::getStats() const
+{
+    return _impl->getStats();
+}
+
 void Subscriber::addSockets( std::vector< detail::Socket >& entries )
 {
     _impl->addSockets( entries );
 }
 
-void Subscriber::process( detail::Socket& socket )
+size_t Subscriber::process( detail::Socket& socket )
 {
-    _impl->process( socket );
+    return _impl->process( socket, getExecutor( ));
 }
 
 void Subscriber::update()
 {
-    _impl->update( getZMQContext( ));
+    _impl->update();
 }
 
 void Subscriber::addConnection( const std::string& uri )
 {
-    _impl->addConnection( getZMQContext(), uri, uint128_t( ));
+    _impl->addConnection( uri, uint128_t( ));
 }
 
 }
@@ -33,6 +33,20 @@ namespace zeq
 class Subscriber : public Receiver
 {
 public:
+    /**
+     * Counters of the compressed events received by a subscriber, see
+     * Publisher::setCompression().
+     *
+     * The compression ratio is decompressedBytes / compressedBytes.
+     */
+    struct Stats
+    {
+        uint64_t decompressed; //!< compressed events received
+        uint64_t compressedBytes; //!< received size of compressed events
+        uint64_t decompressedBytes; //!< payload size of compressed events
+        uint64_t decompressionTime; //!< decompression time in microseconds
+    };
+
     /**
      * Create a default subscriber.
      *
@@ -143,14 +157,27 @@ public:
     /**
      * Register a new callback for an event.
      *
-     * Only one callback per event is possible in the current implementation.
+     * Fails if callbacks for the event are registered already, see
+     * addHandler() to register multiple callbacks.
+     *
+     * With DELIVER_LATEST, the pending events of this type are conflated: only
+     * the newest one is delivered during a receive, the older ones are dropped
+     * without being parsed. The conflated event is delivered after the other
+     * events received alongside. This suits state-like events, e.g., camera
+     * updates. All publishers share one connection, so events of this type
+     * from different publishers are conflated as well; use one subscriber per
+     * publisher to get the latest state of each.
      *
      * @param event the event type of interest
      * @param func the callback function on receive of event
-     * @return true if callback could be registered
+     * @param delivery deliver all or only the latest pending events
+     * @return true if callback could be registered, false if callbacks are
+     *         registered already or the subscribed serializable of the
+     *         event uses another delivery mode
      */
     ZEQ_API bool registerHandler( const uint128_t& event,
-                                  const EventFunc& func );
+                                  const EventFunc& func,
+                                  Delivery delivery = DELIVER_ALL );
 
     /**
      * Deregister a callback for an event.
@@ -163,6 +190,36 @@ public:
     /** @return true if a handler is registered for the given event. */
     ZEQ_API bool hasHandler( const uint128_t& event ) const;
 
+    /**
+     * Add a callback for an event, in addition to the registered ones.
+     *
+     * The callbacks of an event are called in the order they were added, all
+     * with the same received Event. All callbacks and the subscribed
+     * serializable of an event have to use the same delivery mode, see
+     * registerHandler().
+     *
+     * @param event the event type of interest
+     * @param func the callback function on receive of event
+     * @param delivery deliver all or only the latest pending events
+     * @return the token to remove the callback with removeHandler(), 0 if the
+     *         delivery mode differs from the one of the existing callbacks
+     */
+    ZEQ_API HandlerToken addHandler( const uint128_t& event,
+                                     const EventFunc& func,
+                                     Delivery delivery = DELIVER_ALL );
+
+    /**
+     * Remove a callback added by addHandler().
+     *
+     * Callbacks registered by registerHandler() are removed with
+     * deregisterHandler(). A callback may remove callbacks while being called;
+     * removed callbacks are not called anymore for the current event.
+     *
+     * @param token the token returned by addHandler()
+     * @return true if the callback was removed
+     */
+    ZEQ_API bool removeHandler( HandlerToken token );
+
     /**
      * Subscribe a serializable object to receive updates from any connected
      * publisher.
@@ -171,12 +228,19 @@ public:
      * track updates on the object, the serializable's updated function is
      * called accordingly.
      *
-     * The subscribed object instance has to be valid until unsubscribe().
+     * The subscribed object instance has to be valid until unsubscribe() or
+     * the destruction of this subscriber. Updates posted to a dispatcher or
+     * executor which did not run yet are skipped afterwards, a running update
+     * finishes before unsubscribe() returns.
      *
      * @param serializable the object to update on receive()
+     * @param delivery apply all or only the latest pending updates, see
+     *                 registerHandler(). Has to match the delivery mode of
+     *                 the callbacks of the same type.
      * @return true if subscription was successful, false otherwise
      */
-    ZEQ_API bool subscribe( servus::Serializable& serializable );
+    ZEQ_API bool subscribe( servus::Serializable& serializable,
+                            Delivery delivery = DELIVER_ALL );
 
     /**
      * Unsubscribe a serializable object to stop applying updates from any
@@ -187,16 +251,99 @@ public:
      */
     ZEQ_API bool unsubscribe( const servus::Serializable& serializable );
 
+    /**
+     * Subscribe to events of the given type for collect().
+     *
+     * The events are received without a handler and gathered by collect().
+     * Events of the type received meanwhile by receive() are kept until the
+     * next collect(), up to 65536 events, newer ones are dropped. Handlers or
+     * a serializable of the same type are called in addition.
+     *
+     * Collected events are never conflated. Handlers registered with
+     * DELIVER_LATEST are called for each event received by collect(), only
+     * receive() conflates them.
+     *
+     * @param type the event type to collect
+     * @return true if subscription was successful, false if the type is
+     *         subscribed already
+     */
+    ZEQ_API bool subscribe( const uint128_t& type );
+
+    /**
+     * Stop collecting events of the given type, dropping any not collected.
+     *
+     * @param type the event type to stop collecting
+     * @return true if removal of subscription was successful, false otherwise
+     */
+    ZEQ_API bool unsubscribe( const uint128_t& type );
+
+    /**
+     * Append all pending events of the subscribed types to the given batch.
+     *
+     * Waits up to timeout for events if none are pending, then receives all
+     * events available without blocking, but at most 65536 per call. Publishers
+     * discovered while waiting are connected right away. Events
+     * of types with a handler or serializable are dispatched to them as in
+     * receive(). Clear and reuse the batch across calls to avoid allocations.
+     * Only receives from this subscriber, not from a shared group.
+     *
+     * @param batch the batch to append the events to
+     * @param timeout timeout in ms to wait for events, 0 to only take the
+     *                pending ones
+     * @return the number of events appended to the batch
+     * @throw std::runtime_error when polling failed.
+     */
+    ZEQ_API size_t collect( EventBatch& batch, uint32_t timeout = 0 );
+
+    /**
+     * Append the pending events of the given type to the given batch.
+     *
+     * Like collect() above, but events of other subscribed types are kept for
+     * a later collect().
+     *
+     * @param batch the batch to append the events to
+     * @param type the event type to collect, subscribed by subscribe()
+     * @param timeout timeout in ms to wait for events, 0 to only take the
+     *                pending ones
+     * @return the number of events appended to the batch
+     * @throw std::runtime_error when polling failed.
+     */
+    ZEQ_API size_t collect( EventBatch& batch, const uint128_t& type,
+                            uint32_t timeout = 0 );
+
     /** @return the session name that is used for filtering. */
     ZEQ_API const std::string& getSession() const;
 
+    /**
+     * Run the event handlers and serializable updates on the given dispatcher.
+     *
+     * Events of the same type are handled in the order of reception, events
+     * of different types concurrently on the dispatcher's worker threads.
+     * Receiving blocks while the dispatcher's queue is full. Handlers must be
+     * thread safe with respect to each other. Takes precedence over an
+     * executor given to Receiver::start().
+     *
+     * @param dispatcher the dispatcher to use, which has to be valid until it
+     *                   is unset, or nullptr to run handlers while receiving
+     */
+    ZEQ_API void setDispatcher( Dispatcher* dispatcher );
+
+    /**
+     * @return the decompression counters of this subscriber, may be called
+     *         from any thread.
+     */
+    ZEQ_API Stats getStats() const;
+
 private:
     class Impl;
     std::unique_ptr< Impl > _impl;
 
+    size_t _collect( EventBatch& batch, const uint128_t* type,
+                     uint32_t timeout );
+
     // Receiver API
     void addSockets( std::vector< detail::Socket >& entries ) final;
-    void process( detail::Socket& socket ) final;
+    size_t process( detail::Socket& socket ) final;
     void update() final;
     void addConnection( const std::string& uri ) final;
 };
@@ -33,7 +33,9 @@ namespace zeq
 {
 
 using servus::uint128_t;
+class Dispatcher;
 class Event;
+class EventBatch;
 class Publisher;
 class Subscriber;
 class URI;
@@ -43,6 +45,17 @@ typedef std::shared_ptr< const uint8_t > ConstByteArray;
 
 typedef std::vector< EventDescriptor > EventDescriptors;
 typedef std::function< void( const Event& ) > EventFunc;
+typedef std::function< Event() > EventProducer;
+typedef uint64_t HandlerToken; //!< Identifies a handler added to a Subscriber
+typedef std::function< void() > Task;
+typedef std::function< void( const Task& ) > Executor;
+
+#ifdef _WIN32
+typedef uintptr_t FileDescriptor; //!< A native socket handle (SOCKET)
+#else
+typedef int FileDescriptor; //!< A native file descriptor
+#endif
+typedef std::vector< FileDescriptor > FileDescriptors;
 
 /** Constant defining 'wait forever' in methods with wait parameters. */
 // Attn: identical to Win32 INFINITE!
@@ -55,6 +68,42 @@ static const std::string NULL_SESSION = "__null_session";
 
 namespace detail { struct Socket; }
 
+/** Encoding of published events on the wire. */
+enum WireFormat
+{
+    /** Type and payload in separate frames, understood by all versions */
+    FORMAT_TWO_FRAMES,
+    /**
+     * Type prefixed to the payload in one frame, needs zeq 0.5 subscribers.
+     * Not negotiated, older subscribers receive events without payload.
+     */
+    FORMAT_SINGLE_FRAME
+};
+
+/** Compression of event payloads by a Publisher. */
+enum Compression
+{
+    COMPRESSION_NONE, //!< Send payloads as they are
+    COMPRESSION_LZ4, //!< Fast LZ4 compression, if zeq was built with LZ4
+    COMPRESSION_ZSTD //!< Stronger zstd compression, if zeq was built with zstd
+};
+
+/** Behaviour of an asynchronous Publisher when its send queue is full. */
+enum OverflowPolicy
+{
+    OVERFLOW_BLOCK, //!< Wait until the send thread made room in the queue
+    OVERFLOW_DROP_NEWEST, //!< Drop the event to be published
+    OVERFLOW_DROP_OLDEST //!< Send thread drops the oldest queued events
+};
+
+/** Delivery of the events of one type pending in a Subscriber. */
+enum Delivery
+{
+    DELIVER_ALL, //!< Deliver every received event in order
+    DELIVER_LATEST //!< Deliver only the newest pending event per receive,
+                   //!< across all publishers of a Subscriber
+};
+
 /** @deprecated */
 enum AnnounceMode //!< Network presence announcements
 {
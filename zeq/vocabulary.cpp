@@ -50,6 +50,11 @@ Event serializeJSON( const uint128_t& type, const std::string& json )
     return detail::serializeJSON( type, json );
 }
 
+void deserializeJSON( const Event& event, std::string& json )
+{
+    detail::deserializeJSON( event, json );
+}
+
 std::string deserializeJSON( const Event& event )
 {
     return detail::deserializeJSON( event );
@@ -66,12 +66,15 @@ ZEQ_API uint128_t deserializeRequest( const Event& event );
 /**
  * @name JSON/binary event translation.
  *
- * These functions are not thread-safe, that is, calling registerEvent()
- * concurrently with any of the other functions in this group needs external
- * serialization.
+ * These functions are thread-safe. registerEvent() compiles the schema once,
+ * the conversions only parse or generate the JSON. Schema lookups are
+ * lock-free, so conversions on many threads do not contend.
  */
 //@{
 /** Establish a type to schema mapping for (de)serialization from/to JSON.
+ *
+ * The schema is compiled right away, errors in the schema are reported by the
+ * conversions of the type.
  *
  * @param type the type of the event.
  * @param schema the schema as string of the event.
@@ -108,6 +111,17 @@ ZEQ_API Event serializeJSON( const uint128_t& type, const std::string& json );
  * @throw std::runtime_error when the given event is not registered.
  */
 ZEQ_API std::string deserializeJSON( const Event& event );
+
+/** Deserialize a zeq::Event to JSON into the given string.
+ *
+ * Like deserializeJSON() above, but reuses the memory of the given string,
+ * e.g., for repeated conversions.
+ *
+ * @param event the zeq::Event to deserialize into JSON.
+ * @param json the string to replace with the JSON of the event.
+ * @throw std::runtime_error when the given event is not registered.
+ */
+ZEQ_API void deserializeJSON( const Event& event, std::string& json );
 //@}
 
 }